@@ -1,12 +1,36 @@
 #include <cassert>
 #include <random>
-#include <list>
 #include <span>
 #include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
 #include <ranges>
 #include <print>
 #include <vector>
 #include <algorithm>
+#include <limits>
+#include <cmath>
+#include <numeric>
+#include <cstdio>
+#include <optional>
+#include <chrono>
+#include <string_view>
+#include <concepts>
+#include <numbers>
+#include <charconv>
+#include <thread>
+#include <atomic>
+#include <array>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <filesystem>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <raylib.h>
 #include <raymath.h>
@@ -18,13 +42,69 @@
 static constexpr int WIDTH = 1600;
 static constexpr int HEIGHT = 900;
 
+#ifdef PATHFINDING_COUNT_ALLOCATIONS
+// heap allocations of the calling thread so far, counted by the replaced global operator new below
+// only for bench allocations, normal builds keep the default allocator
+static thread_local size_t allocation_count = 0;
+
+void *operator new(size_t size) {
+    allocation_count++;
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc();
+}
+
+// operator new above is malloc(), gcc doesn't know that and warns about free() wherever these are inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#pragma GCC diagnostic pop
+#endif
+
 namespace ranges = std::ranges;
 
 using VertexId = int64_t;
+using Weight = uint32_t;
+
+// types that solvers can accumulate distances in
+// narrow types keep the tables and heaps small, wide ones can't run out of range on large graphs
+template <typename T>
+concept Distance = (std::unsigned_integral<T> && !std::same_as<T, bool>) || std::floating_point<T>;
+
+// marks unreachable vertices, additions saturate at this value instead of wrapping around
+template <Distance Dist>
+static constexpr Dist INF_DISTANCE = std::numeric_limits<Dist>::has_infinity
+    ? std::numeric_limits<Dist>::infinity()
+    : std::numeric_limits<Dist>::max();
+
+template <Distance Dist>
+[[nodiscard]] static constexpr Dist saturating_add(Dist a, Dist b) {
+    if constexpr (std::floating_point<Dist>) {
+        return a + b;
+    } else {
+        return a > INF_DISTANCE<Dist> - b ? INF_DISTANCE<Dist> : a + b;
+    }
+}
+
+// an arc weight as a distance: saturates at INF_DISTANCE for types narrower than Weight instead of wrapping around
+// to a shorter distance
+template <Distance Dist>
+[[nodiscard]] static constexpr Dist weight_to_distance(Weight weight) {
+    if constexpr (std::integral<Dist> && sizeof(Dist) < sizeof(Weight)) {
+        return static_cast<Dist>(std::min<Weight>(weight, INF_DISTANCE<Dist>));
+    } else {
+        return static_cast<Dist>(weight);
+    }
+}
 
 struct Edge {
     VertexId m_other_id;
-    int m_weight;
+    Weight m_weight;
 };
 
 struct Vertex {
@@ -33,27 +113,911 @@ struct Vertex {
     Vector2 m_pos;
 };
 
+template <Distance Dist>
+struct Route {
+    Dist m_dist;
+    std::vector<VertexId> m_path; // source and destination included
+};
+
+// dense sources x targets table of shortest distances, INF_DISTANCE where a target can't be reached from a source
+template <Distance Dist>
+struct DistanceMatrix {
+    size_t m_rows; // sources
+    size_t m_columns; // targets
+    std::vector<Dist> m_dists; // row major, one contiguous row per source
+
+    [[nodiscard]] Dist at(size_t row, size_t column) const {
+        return m_dists[row * m_columns + column];
+    }
+
+    [[nodiscard]] std::span<Dist> row(size_t row) {
+        return std::span(m_dists).subspan(row * m_columns, m_columns);
+    }
+};
+
+// dense 0..N-1 index of a vertex inside a Graph
+using VertexIndex = uint32_t;
+static constexpr VertexIndex NO_VERTEX = std::numeric_limits<VertexIndex>::max();
+
+struct Arc {
+    VertexIndex m_target;
+    Weight m_weight;
+};
+
+// read only memory mapping of a whole file
+class MappedFile {
+    void *m_data = nullptr;
+    size_t m_size = 0;
+    bool m_ok = false;
+
+public:
+    explicit MappedFile(const char *filename) {
+        int fd = open(filename, O_RDONLY);
+        if (fd == -1) return;
+
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            m_size = st.st_size;
+            // an empty file can't be mapped, but is a valid empty mapping
+            m_ok = m_size == 0;
+            if (m_size != 0) {
+                void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    m_data = data;
+                    m_ok = true;
+                }
+            }
+        }
+        close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        if (m_data != nullptr) munmap(m_data, m_size);
+    }
+
+    [[nodiscard]] bool is_open() const {
+        return m_ok;
+    }
+
+    [[nodiscard]] std::span<const char> data() const {
+        return { static_cast<const char*>(m_data), m_size };
+    }
+
+};
+
+// immutable graph in compressed sparse row layout
+// vertex ids are only used at the edges of the api, everything else works on dense indices
+class Graph {
+    static constexpr uint32_t m_file_magic = 0x52474650; // "PFGR"
+    static constexpr uint32_t m_file_version = 2;
+    // arrays in a snapshot start at multiples of this, relative to the start of the file
+    static constexpr size_t m_file_alignment = 64;
+
+    struct FileHeader {
+        uint32_t m_magic;
+        uint32_t m_version;
+        // sizes of the stored types, a snapshot can only be loaded where they are the same
+        uint32_t m_offset_size;
+        uint32_t m_arc_size;
+        uint32_t m_position_size;
+        uint32_t m_id_size;
+        uint64_t m_vertex_count;
+        uint64_t m_arc_count;
+        float m_weight_per_length;
+        uint32_t m_reserved;
+    };
+
+    // file offsets of the arrays in a snapshot
+    struct FileLayout {
+        size_t m_offsets;
+        size_t m_arcs;
+        size_t m_reverse_offsets;
+        size_t m_reverse_arcs;
+        size_t m_positions;
+        size_t m_ids;
+        size_t m_id_order;
+        size_t m_size;
+    };
+
+    struct Arrays {
+        std::vector<size_t> m_offsets;
+        std::vector<Arc> m_arcs;
+        std::vector<size_t> m_reverse_offsets;
+        std::vector<Arc> m_reverse_arcs;
+        std::vector<Vector2> m_positions;
+        std::vector<VertexId> m_ids;
+        std::vector<VertexIndex> m_id_order;
+    };
+
+    // owns the memory the views below point into: Arrays built by the constructor, or a MappedFile of a snapshot
+    // shared and never modified, so copies of a graph are cheap
+    std::shared_ptr<const void> m_storage;
+
+    // arcs of vertex i are m_arcs[m_offsets[i], m_offsets[i+1])
+    std::span<const size_t> m_offsets;
+    std::span<const Arc> m_arcs;
+    // same layout for the reversed graph: incoming arcs of vertex i, m_target is the tail of the arc
+    std::span<const size_t> m_reverse_offsets;
+    std::span<const Arc> m_reverse_arcs;
+    std::span<const Vector2> m_positions;
+    std::span<const VertexId> m_ids;
+    // indices sorted by their id, for looking up ids in any vertex order
+    std::span<const VertexIndex> m_id_order;
+    // lower bound of weight per unit of euclidean distance between positions, over all arcs
+    // scaling the distance between two positions by this never overestimates the shortest path between them
+    float m_weight_per_length = std::numeric_limits<float>::infinity();
+
+public:
+    explicit Graph(const std::unordered_map<VertexId, Vertex> &vertices) {
+        auto arrays = std::make_shared<Arrays>();
+
+        // sort by id, so that indices don't depend on the iteration order of the map
+        auto &ids = arrays->m_ids;
+        ids.reserve(vertices.size());
+        for (auto &[id, vtx] : vertices) {
+            ids.push_back(id);
+        }
+        ranges::sort(ids);
+
+        std::unordered_map<VertexId, VertexIndex> index;
+        index.reserve(ids.size());
+        for (auto &&[idx, id] : std::views::enumerate(ids)) {
+            index.emplace(id, static_cast<VertexIndex>(idx));
+        }
+
+        auto &offsets = arrays->m_offsets;
+        auto &arcs = arrays->m_arcs;
+        offsets.reserve(ids.size() + 1);
+        arrays->m_positions.reserve(ids.size());
+        offsets.push_back(0);
+
+        for (auto id : ids) {
+            auto &vtx = vertices.at(id);
+            arrays->m_positions.push_back(vtx.m_pos);
+
+            for (auto &edge : vtx.m_neighbours) {
+                arcs.push_back({ index.at(edge.m_other_id), edge.m_weight });
+            }
+            offsets.push_back(arcs.size());
+        }
+
+        build_reverse_arcs(*arrays);
+        arrays->m_id_order.resize(ids.size());
+        std::iota(arrays->m_id_order.begin(), arrays->m_id_order.end(), VertexIndex { 0 });
+        adopt(std::move(arrays));
+
+        for (VertexIndex idx = 0; idx < size(); ++idx) {
+            for (auto &arc : neighbours(idx)) {
+                float length = Vector2Distance(position(idx), position(arc.m_target));
+                if (length > 0) {
+                    m_weight_per_length = std::min(m_weight_per_length, arc.m_weight / length);
+                }
+            }
+        }
+
+        // no arc of non-zero length, positions tell nothing about distances
+        if (std::isinf(m_weight_per_length)) {
+            m_weight_per_length = 0;
+        }
+    }
+
+    // writes a snapshot that load() can map back without parsing anything
+    [[nodiscard]] bool save(const char *filename) const {
+        FILE *file = std::fopen(filename, "wb");
+        if (file == nullptr) return false;
+
+        FileHeader header {
+            m_file_magic,
+            m_file_version,
+            sizeof(size_t),
+            sizeof(Arc),
+            sizeof(Vector2),
+            sizeof(VertexId),
+            size(),
+            arc_count(),
+            m_weight_per_length,
+            0,
+        };
+        auto layout = file_layout(size(), arc_count());
+
+        size_t pos = 0;
+        auto write_at = [&](size_t offset, auto data) {
+            static constexpr char padding[m_file_alignment] { };
+            assert(offset >= pos && offset - pos <= sizeof padding);
+            size_t size = data.size_bytes();
+            bool ok = std::fwrite(padding, 1, offset - pos, file) == offset - pos
+                && (size == 0 || std::fwrite(data.data(), 1, size, file) == size);
+            pos = offset + size;
+            return ok;
+        };
+
+        bool ok = write_at(0, std::span(&header, 1))
+            && write_at(layout.m_offsets, m_offsets)
+            && write_at(layout.m_arcs, m_arcs)
+            && write_at(layout.m_reverse_offsets, m_reverse_offsets)
+            && write_at(layout.m_reverse_arcs, m_reverse_arcs)
+            && write_at(layout.m_positions, m_positions)
+            && write_at(layout.m_ids, m_ids)
+            && write_at(layout.m_id_order, m_id_order);
+
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // maps a snapshot written by save() and uses its arrays in place, pages are only read in once they are used
+    // nullopt if the file is missing or was written by another version or platform
+    // the contents are trusted, only the header and the array bounds are checked
+    [[nodiscard]] static std::optional<Graph> load(const char *filename) {
+        auto file = std::make_shared<MappedFile>(filename);
+        if (!file->is_open()) return std::nullopt;
+
+        auto data = file->data();
+        FileHeader header;
+        if (data.size() < sizeof header) return std::nullopt;
+        std::memcpy(&header, data.data(), sizeof header);
+
+        bool ok = header.m_magic == m_file_magic
+            && header.m_version == m_file_version
+            && header.m_offset_size == sizeof(size_t)
+            && header.m_arc_size == sizeof(Arc)
+            && header.m_position_size == sizeof(Vector2)
+            && header.m_id_size == sizeof(VertexId)
+            && header.m_vertex_count < NO_VERTEX;
+        if (!ok) return std::nullopt;
+
+        size_t vertex_count = header.m_vertex_count;
+        size_t arc_count = header.m_arc_count;
+        auto layout = file_layout(vertex_count, arc_count);
+        if (layout.m_size != data.size()) return std::nullopt;
+
+        auto array = [&]<typename T>(size_t offset, size_t count, std::span<const T> &out) {
+            out = { reinterpret_cast<const T*>(data.data() + offset), count };
+        };
+
+        Graph graph(Loaded { });
+        array(layout.m_offsets, vertex_count + 1, graph.m_offsets);
+        array(layout.m_arcs, arc_count, graph.m_arcs);
+        array(layout.m_reverse_offsets, vertex_count + 1, graph.m_reverse_offsets);
+        array(layout.m_reverse_arcs, arc_count, graph.m_reverse_arcs);
+        array(layout.m_positions, vertex_count, graph.m_positions);
+        array(layout.m_ids, vertex_count, graph.m_ids);
+        array(layout.m_id_order, vertex_count, graph.m_id_order);
+        graph.m_weight_per_length = header.m_weight_per_length;
+        graph.m_storage = std::move(file);
+
+        ok = graph.m_offsets.front() == 0 && graph.m_offsets.back() == arc_count
+            && graph.m_reverse_offsets.front() == 0 && graph.m_reverse_offsets.back() == arc_count;
+        if (!ok) return std::nullopt;
+
+        return graph;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return m_ids.size();
+    }
+
+    [[nodiscard]] size_t arc_count() const {
+        return m_arcs.size();
+    }
+
+    // size of the arrays of a graph with that many vertices and arcs, in memory and in a snapshot
+    [[nodiscard]] static size_t memory_bytes(size_t vertex_count, size_t arc_count) {
+        size_t per_vertex = 2 * sizeof(size_t) + sizeof(Vector2) + sizeof(VertexId) + sizeof(VertexIndex);
+        size_t per_arc = 2 * sizeof(Arc);
+        return 2 * sizeof(size_t) + vertex_count * per_vertex + arc_count * per_arc;
+    }
+
+    [[nodiscard]] size_t memory_bytes() const {
+        return memory_bytes(size(), arc_count());
+    }
+
+    [[nodiscard]] std::span<const Arc> neighbours(VertexIndex idx) const {
+        return { m_arcs.data() + m_offsets[idx], m_arcs.data() + m_offsets[idx+1] };
+    }
+
+    [[nodiscard]] std::span<const Arc> incoming(VertexIndex idx) const {
+        return { m_reverse_arcs.data() + m_reverse_offsets[idx], m_reverse_arcs.data() + m_reverse_offsets[idx+1] };
+    }
+
+    [[nodiscard]] Vector2 position(VertexIndex idx) const {
+        return m_positions[idx];
+    }
+
+    [[nodiscard]] VertexId id(VertexIndex idx) const {
+        return m_ids[idx];
+    }
+
+    // throws std::out_of_range for ids that are not in the graph
+    [[nodiscard]] VertexIndex index(VertexId id) const {
+        auto it = ranges::lower_bound(m_id_order, id, { }, [&](VertexIndex idx) { return m_ids[idx]; });
+        if (it == m_id_order.end() || m_ids[*it] != id) {
+            throw std::out_of_range(std::format("no vertex with id {}", id));
+        }
+        return *it;
+    }
+
+    // the same graph with its vertices stored in another order: vertex order[i] of this graph becomes vertex i
+    // ids and weights stay the same, only indices change. vertices that are close in memory when they are close
+    // in the graph make searches touch fewer cache lines, see hilbert_order() and bfs_order()
+    [[nodiscard]] Graph permuted(std::span<const VertexIndex> order) const {
+        assert(order.size() == size());
+
+        std::vector<VertexIndex> new_index(size(), NO_VERTEX);
+        for (auto &&[idx, old] : std::views::enumerate(order)) {
+            assert(new_index[old] == NO_VERTEX);
+            new_index[old] = static_cast<VertexIndex>(idx);
+        }
+
+        auto arrays = std::make_shared<Arrays>();
+        arrays->m_offsets.reserve(size() + 1);
+        arrays->m_arcs.reserve(arc_count());
+        arrays->m_positions.reserve(size());
+        arrays->m_ids.reserve(size());
+        arrays->m_offsets.push_back(0);
+
+        for (auto old : order) {
+            arrays->m_positions.push_back(position(old));
+            arrays->m_ids.push_back(id(old));
+            for (auto &arc : neighbours(old)) {
+                arrays->m_arcs.push_back({ new_index[arc.m_target], arc.m_weight });
+            }
+            arrays->m_offsets.push_back(arrays->m_arcs.size());
+        }
+
+        build_reverse_arcs(*arrays);
+        arrays->m_id_order.reserve(size());
+        for (auto old : m_id_order) {
+            arrays->m_id_order.push_back(new_index[old]);
+        }
+
+        Graph graph(Loaded { });
+        graph.adopt(std::move(arrays));
+        graph.m_weight_per_length = m_weight_per_length;
+        return graph;
+    }
+
+    // hash of the ids in vertex order and of all arcs, to tell whether data derived from a graph belongs to this one
+    [[nodiscard]] uint64_t fingerprint() const {
+        // fnv-1a
+        uint64_t hash = 0xcbf29ce484222325;
+        auto add = [&](std::span<const std::byte> bytes) {
+            for (auto byte : bytes) {
+                hash = (hash ^ static_cast<uint64_t>(byte)) * 0x100000001b3;
+            }
+        };
+        add(std::as_bytes(m_ids));
+        add(std::as_bytes(m_offsets));
+        add(std::as_bytes(m_arcs));
+        return hash;
+    }
+
+    // admissible and consistent estimate of the shortest path length between two vertices
+    [[nodiscard]] double estimate_distance(VertexIndex a, VertexIndex b) const {
+        // shave off a bit, so float rounding can't push the estimate above the real distance
+        return Vector2Distance(position(a), position(b)) * static_cast<double>(m_weight_per_length) * 0.9999;
+    }
+
+private:
+    struct Loaded { };
+    explicit Graph(Loaded) { }
+
+    void adopt(std::shared_ptr<Arrays> arrays) {
+        m_offsets = arrays->m_offsets;
+        m_arcs = arrays->m_arcs;
+        m_reverse_offsets = arrays->m_reverse_offsets;
+        m_reverse_arcs = arrays->m_reverse_arcs;
+        m_positions = arrays->m_positions;
+        m_ids = arrays->m_ids;
+        m_id_order = arrays->m_id_order;
+        m_storage = std::move(arrays);
+    }
+
+    [[nodiscard]] static FileLayout file_layout(size_t vertex_count, size_t arc_count) {
+        auto align = [](size_t offset) {
+            return (offset + m_file_alignment - 1) / m_file_alignment * m_file_alignment;
+        };
+
+        FileLayout layout { };
+        layout.m_offsets = align(sizeof(FileHeader));
+        layout.m_arcs = align(layout.m_offsets + (vertex_count + 1) * sizeof(size_t));
+        layout.m_reverse_offsets = align(layout.m_arcs + arc_count * sizeof(Arc));
+        layout.m_reverse_arcs = align(layout.m_reverse_offsets + (vertex_count + 1) * sizeof(size_t));
+        layout.m_positions = align(layout.m_reverse_arcs + arc_count * sizeof(Arc));
+        layout.m_ids = align(layout.m_positions + vertex_count * sizeof(Vector2));
+        layout.m_id_order = align(layout.m_ids + vertex_count * sizeof(VertexId));
+        layout.m_size = layout.m_id_order + vertex_count * sizeof(VertexIndex);
+        return layout;
+    }
+
+    // counting sort of all arcs by their head
+    static void build_reverse_arcs(Arrays &arrays) {
+        size_t vertex_count = arrays.m_ids.size();
+        auto &reverse_offsets = arrays.m_reverse_offsets;
+
+        reverse_offsets.assign(vertex_count + 1, 0);
+        for (auto &arc : arrays.m_arcs) {
+            reverse_offsets[arc.m_target + 1]++;
+        }
+        std::partial_sum(reverse_offsets.begin(), reverse_offsets.end(), reverse_offsets.begin());
+
+        std::vector<size_t> fill(reverse_offsets.begin(), reverse_offsets.end() - 1);
+        arrays.m_reverse_arcs.resize(arrays.m_arcs.size());
+        for (VertexIndex idx = 0; idx < vertex_count; ++idx) {
+            for (size_t i = arrays.m_offsets[idx]; i < arrays.m_offsets[idx+1]; ++i) {
+                auto &arc = arrays.m_arcs[i];
+                arrays.m_reverse_arcs[fill[arc.m_target]++] = { idx, arc.m_weight };
+            }
+        }
+    }
+
+};
+
+// distance along a hilbert curve through a 2^16 x 2^16 grid, points close on the curve are close on the grid
+[[nodiscard]] static uint64_t hilbert_index(uint32_t x, uint32_t y) {
+    constexpr uint32_t n = 1 << 16;
+    uint64_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+        // rotate the quadrant, so the curve inside it starts and ends next to the neighbouring quadrants
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// vertex order for Graph::permuted() along a hilbert curve over the positions, so vertices close on the map are
+// close in memory. only looks at positions, ties are broken by id
+[[nodiscard]] static std::vector<VertexIndex> hilbert_order(const Graph &graph) {
+    Vector2 min { std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    Vector2 max { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+    for (VertexIndex idx = 0; idx < graph.size(); ++idx) {
+        auto pos = graph.position(idx);
+        min = { std::min(min.x, pos.x), std::min(min.y, pos.y) };
+        max = { std::max(max.x, pos.x), std::max(max.y, pos.y) };
+    }
+
+    auto cell = [](float value, float min, float max) {
+        if (!(max > min)) return 0u;
+        return static_cast<uint32_t>(std::clamp((value - min) / (max - min), 0.0f, 1.0f) * 65535.0f);
+    };
+
+    std::vector<std::pair<uint64_t, VertexIndex>> keys;
+    keys.reserve(graph.size());
+    for (VertexIndex idx = 0; idx < graph.size(); ++idx) {
+        auto pos = graph.position(idx);
+        keys.push_back({ hilbert_index(cell(pos.x, min.x, max.x), cell(pos.y, min.y, max.y)), idx });
+    }
+    ranges::sort(keys, [&](auto &a, auto &b) {
+        return a.first != b.first ? a.first < b.first : graph.id(a.second) < graph.id(b.second);
+    });
+
+    std::vector<VertexIndex> order;
+    order.reserve(keys.size());
+    for (auto &[key, idx] : keys) {
+        order.push_back(idx);
+    }
+    return order;
+}
+
+// vertex order for Graph::permuted() in breadth first order over arcs in both directions, so the neighbours of a
+// vertex mostly sit in a small window around it. every component starts at its vertex that comes first in the
+// current order
+[[nodiscard]] static std::vector<VertexIndex> bfs_order(const Graph &graph) {
+    std::vector<VertexIndex> order;
+    order.reserve(graph.size());
+    std::vector<bool> seen(graph.size(), false);
+
+    for (VertexIndex root = 0; root < graph.size(); ++root) {
+        if (seen[root]) continue;
+        seen[root] = true;
+        size_t head = order.size();
+        order.push_back(root);
+
+        // the order itself is the queue
+        for (; head < order.size(); ++head) {
+            VertexIndex idx = order[head];
+            for (auto arcs : { graph.neighbours(idx), graph.incoming(idx) }) {
+                for (auto &arc : arcs) {
+                    if (seen[arc.m_target]) continue;
+                    seen[arc.m_target] = true;
+                    order.push_back(arc.m_target);
+                }
+            }
+        }
+    }
+    return order;
+}
+
+// the vertices of a graph in the format graphs are built from, for passes like contract_chains()
+[[nodiscard]] static std::unordered_map<VertexId, Vertex> graph_vertices(const Graph &graph) {
+    std::unordered_map<VertexId, Vertex> vertices;
+    vertices.reserve(graph.size());
+    for (VertexIndex idx = 0; idx < graph.size(); ++idx) {
+        Vertex vtx { graph.id(idx), { }, graph.position(idx) };
+        for (auto &arc : graph.neighbours(idx)) {
+            vtx.m_neighbours.push_back({ graph.id(arc.m_target), arc.m_weight });
+        }
+        vertices.emplace(vtx.m_id, std::move(vtx));
+    }
+    return vertices;
+}
+
+// subgraph of the largest strongly connected component, every vertex in it can reach every other one
+// routing between components always fails, so islands cut off by an extract are dead weight
+[[nodiscard]] static Graph largest_strongly_connected_component(const Graph &graph) {
+    size_t n = graph.size();
+
+    // kosaraju: order the vertices by dfs finish time, then collect the components with dfs on the reversed graph
+    std::vector<VertexIndex> finished;
+    finished.reserve(n);
+    std::vector<bool> seen(n, false);
+    std::vector<std::pair<VertexIndex, size_t>> stack; // vertex and position in its arc list
+
+    for (VertexIndex root = 0; root < n; ++root) {
+        if (seen[root]) continue;
+        seen[root] = true;
+        stack.push_back({ root, 0 });
+
+        while (!stack.empty()) {
+            auto &[idx, next] = stack.back();
+            auto arcs = graph.neighbours(idx);
+            if (next < arcs.size()) {
+                VertexIndex target = arcs[next++].m_target;
+                if (!seen[target]) {
+                    seen[target] = true;
+                    stack.push_back({ target, 0 });
+                }
+            } else {
+                finished.push_back(idx);
+                stack.pop_back();
+            }
+        }
+    }
+
+    std::vector<VertexIndex> component(n, NO_VERTEX);
+    std::vector<size_t> component_sizes;
+    std::vector<VertexIndex> todo;
+
+    for (auto root : finished | std::views::reverse) {
+        if (component[root] != NO_VERTEX) continue;
+
+        VertexIndex current = component_sizes.size();
+        component_sizes.push_back(0);
+        component[root] = current;
+        todo.push_back(root);
+
+        while (!todo.empty()) {
+            VertexIndex idx = todo.back();
+            todo.pop_back();
+            component_sizes[current]++;
+
+            for (auto &arc : graph.incoming(idx)) {
+                if (component[arc.m_target] == NO_VERTEX) {
+                    component[arc.m_target] = current;
+                    todo.push_back(arc.m_target);
+                }
+            }
+        }
+    }
+
+    if (component_sizes.size() <= 1) return graph;
+    VertexIndex largest = ranges::max_element(component_sizes) - component_sizes.begin();
+
+    std::unordered_map<VertexId, Vertex> vertices;
+    vertices.reserve(component_sizes[largest]);
+    for (VertexIndex idx = 0; idx < n; ++idx) {
+        if (component[idx] != largest) continue;
+
+        Vertex vtx { graph.id(idx), { }, graph.position(idx) };
+        for (auto &arc : graph.neighbours(idx)) {
+            // arcs leaving the component can't be part of a cycle through it
+            if (component[arc.m_target] == largest) {
+                vtx.m_neighbours.push_back({ graph.id(arc.m_target), arc.m_weight });
+            }
+        }
+        vertices.emplace(vtx.m_id, std::move(vtx));
+    }
+
+    return Graph(vertices);
+}
+
+// geometry of the vertices removed by contract_chains(), to expand routes and draw the contracted edges
+// stored per direction, as the cheapest chain from a to b isn't necessarily the one from b to a
+class PolylineStore {
+    struct IdPairHash {
+        [[nodiscard]] size_t operator()(std::pair<VertexId, VertexId> ids) const {
+            return std::hash<VertexId> { }(ids.first) ^ std::hash<VertexId> { }(ids.second) * 0x9e3779b97f4a7c15;
+        }
+    };
+
+    struct Range {
+        size_t m_begin;
+        size_t m_size;
+    };
+
+    std::unordered_map<std::pair<VertexId, VertexId>, Range, IdPairHash> m_ranges;
+    std::vector<VertexId> m_ids;
+    std::vector<Vector2> m_positions;
+
+public:
+    // interior vertices of the edge from -> to in order, an empty chain stores nothing
+    // only once per edge, the storage is append only and a replaced polyline would stay behind in it
+    void set(VertexId from, VertexId to, std::span<const VertexId> ids, std::span<const Vector2> positions) {
+        assert(ids.size() == positions.size());
+        assert(!m_ranges.contains({ from, to }));
+        if (ids.empty()) return;
+
+        m_ranges[{ from, to }] = { m_ids.size(), ids.size() };
+        m_ids.insert(m_ids.end(), ids.begin(), ids.end());
+        m_positions.insert(m_positions.end(), positions.begin(), positions.end());
+    }
+
+    [[nodiscard]] std::span<const VertexId> interior_ids(VertexId from, VertexId to) const {
+        auto it = m_ranges.find({ from, to });
+        if (it == m_ranges.end()) return { };
+        return std::span(m_ids).subspan(it->second.m_begin, it->second.m_size);
+    }
+
+    [[nodiscard]] std::span<const Vector2> interior_positions(VertexId from, VertexId to) const {
+        auto it = m_ranges.find({ from, to });
+        if (it == m_ranges.end()) return { };
+        return std::span(m_positions).subspan(it->second.m_begin, it->second.m_size);
+    }
+
+    // route in the contracted graph to the same route through the removed vertices
+    template <Distance Dist>
+    [[nodiscard]] Route<Dist> unpack(const Route<Dist> &route) const {
+        Route<Dist> unpacked { route.m_dist, { } };
+        for (size_t i = 0; i < route.m_path.size(); ++i) {
+            if (i > 0) {
+                auto interior = interior_ids(route.m_path[i-1], route.m_path[i]);
+                unpacked.m_path.insert(unpacked.m_path.end(), interior.begin(), interior.end());
+            }
+            unpacked.m_path.push_back(route.m_path[i]);
+        }
+        return unpacked;
+    }
+
+    [[nodiscard]] size_t vertex_count() const {
+        return m_ids.size();
+    }
+
+    [[nodiscard]] size_t memory_bytes() const {
+        return m_ids.size() * (sizeof(VertexId) + sizeof(Vector2))
+            + m_ranges.size() * (sizeof(std::pair<VertexId, VertexId>) + sizeof(Range));
+    }
+
+};
+
+// collapses chains of vertices that only connect two neighbours, like the shape points along a road, into single
+// edges, the geometry of the removed vertices goes to polylines
+// shortest distances between the remaining vertices don't change, vertices in keep are never removed
+[[nodiscard]] static std::unordered_map<VertexId, Vertex> contract_chains(const std::unordered_map<VertexId, Vertex> &vertices,
+                                                                         PolylineStore &polylines,
+                                                                         std::span<const VertexId> keep = { }) {
+    std::unordered_map<VertexId, std::vector<VertexId>> sources;
+    for (auto &[id, vtx] : vertices) {
+        for (auto &edge : vtx.m_neighbours) {
+            sources[edge.m_other_id].push_back(id);
+        }
+    }
+
+    // vertices that only pass traffic through between two other vertices: both ways, or one way from one to the other
+    std::unordered_set<VertexId> through;
+    for (auto &[id, vtx] : vertices) {
+        auto it = sources.find(id);
+        if (it == sources.end()) continue;
+
+        auto &out = vtx.m_neighbours;
+        auto &in = it->second;
+        bool two_way = out.size() == 2 && in.size() == 2
+            && out[0].m_other_id != out[1].m_other_id
+            && ranges::is_permutation(in, std::array { out[0].m_other_id, out[1].m_other_id });
+        bool one_way = out.size() == 1 && in.size() == 1 && out[0].m_other_id != in[0];
+        bool loop = ranges::find(in, id) != in.end();
+
+        if ((two_way || one_way) && !loop) {
+            through.insert(id);
+        }
+    }
+    for (auto id : keep) {
+        through.erase(id);
+    }
+
+    std::unordered_map<VertexId, Vertex> contracted;
+    for (auto &[id, vtx] : vertices) {
+        if (!through.contains(id)) {
+            contracted.emplace(id, Vertex { id, { }, vtx.m_pos });
+        }
+    }
+
+    std::unordered_set<VertexId> covered;
+    // interior vertices of the chains of one start, the chain of its i-th contracted edge is at chain_ranges[i]
+    // a chain that loses to a cheaper parallel one stays behind here, only the winners go to polylines
+    std::vector<VertexId> chain_ids;
+    std::vector<Vector2> chain_positions;
+    std::vector<std::pair<size_t, size_t>> chain_ranges;
+
+    // follows every edge of start through the chain it begins, and adds one edge to where the chain ends
+    auto walk_from = [&](VertexId start) {
+        auto &neighbours = contracted.at(start).m_neighbours;
+        assert(neighbours.empty());
+        chain_ids.clear();
+        chain_positions.clear();
+        chain_ranges.clear();
+
+        for (auto &edge : vertices.at(start).m_neighbours) {
+            VertexId prev = start;
+            VertexId current = edge.m_other_id;
+            uint64_t weight = edge.m_weight;
+            size_t begin = chain_ids.size();
+
+            while (through.contains(current)) {
+                covered.insert(current);
+                auto &vtx = vertices.at(current);
+                chain_ids.push_back(current);
+                chain_positions.push_back(vtx.m_pos);
+
+                // the edge that doesn't lead back
+                auto &out = vtx.m_neighbours;
+                auto &next = out.size() == 1 || out[1].m_other_id == prev ? out[0] : out[1];
+                weight += next.m_weight;
+                prev = current;
+                current = next.m_other_id;
+            }
+
+            Weight clamped = std::min<uint64_t>(weight, std::numeric_limits<Weight>::max());
+            auto parallel = ranges::find(neighbours, current, &Edge::m_other_id);
+            std::pair<size_t, size_t> range { begin, chain_ids.size() - begin };
+
+            // a chain back to its start is never part of a shortest path, of parallel edges only the cheapest can be
+            if (current == start || (parallel != neighbours.end() && clamped >= parallel->m_weight)) {
+                chain_ids.resize(begin);
+                chain_positions.resize(begin);
+            } else if (parallel == neighbours.end()) {
+                neighbours.push_back({ current, clamped });
+                chain_ranges.push_back(range);
+            } else {
+                parallel->m_weight = clamped;
+                chain_ranges[parallel - neighbours.begin()] = range;
+            }
+        }
+
+        for (auto &&[i, edge] : std::views::enumerate(neighbours)) {
+            auto [begin, size] = chain_ranges[i];
+            polylines.set(start, edge.m_other_id, std::span(chain_ids).subspan(begin, size),
+                          std::span(chain_positions).subspan(begin, size));
+        }
+    };
+
+    for (auto &[id, vtx] : contracted) {
+        walk_from(id);
+    }
+
+    // what is left are closed rings without any junction, two neighbouring vertices of each one are kept
+    std::vector<VertexId> rings;
+    for (auto id : through) {
+        if (!covered.contains(id)) rings.push_back(id);
+    }
+    ranges::sort(rings);
+
+    for (auto id : rings) {
+        if (covered.contains(id) || !through.contains(id)) continue;
+
+        auto &vtx = vertices.at(id);
+        VertexId other = vtx.m_neighbours[0].m_other_id;
+        for (auto kept : { id, other }) {
+            through.erase(kept);
+            covered.insert(kept);
+            contracted.emplace(kept, Vertex { kept, { }, vertices.at(kept).m_pos });
+        }
+        walk_from(id);
+        walk_from(other);
+    }
+
+    return contracted;
+}
+
 static inline void draw_text_centered(const std::string &text, Vector2 center, float fontsize, Color color) {
     int textsize = MeasureText(text.c_str(), fontsize);
     DrawText(text.c_str(), center.x-textsize/2.0f, center.y-fontsize/2.0f, fontsize, color);
 }
 
+// distance table of a search, reused across queries and reset in constant time
+// every entry carries the generation of the query that wrote it, entries of earlier queries read as unreached, so
+// a query only ever touches the entries of the vertices it reaches instead of clearing the whole table first
+template <Distance Dist>
+class SearchWorkspace {
+    struct Entry {
+        Dist m_dist; // distance from source vertex
+        VertexIndex m_prev; // previous vertex
+        // m_generation once reached by the current query, m_generation + 1 once settled, older entries are stale
+        uint32_t m_stamp;
+    };
+
+    static constexpr Dist m_inf = INF_DISTANCE<Dist>;
+    std::vector<Entry> m_entries;
+    uint32_t m_generation = 0;
+
+public:
+    // starts a new query on a graph with that many vertices, only allocates if the size changes
+    void reset(size_t vertex_count) {
+        // stamps would wrap around after about two billion queries, start over before that
+        if (m_entries.size() != vertex_count || m_generation >= std::numeric_limits<uint32_t>::max() - 2) {
+            m_entries.assign(vertex_count, { m_inf, NO_VERTEX, 0 });
+            m_generation = 0;
+        }
+        m_generation += 2;
+    }
+
+    [[nodiscard]] bool is_reached(VertexIndex idx) const {
+        return m_entries[idx].m_stamp >= m_generation;
+    }
+
+    [[nodiscard]] bool is_visited(VertexIndex idx) const {
+        return m_entries[idx].m_stamp == m_generation + 1;
+    }
+
+    [[nodiscard]] Dist dist(VertexIndex idx) const {
+        return is_reached(idx) ? m_entries[idx].m_dist : m_inf;
+    }
+
+    [[nodiscard]] VertexIndex prev(VertexIndex idx) const {
+        return is_reached(idx) ? m_entries[idx].m_prev : NO_VERTEX;
+    }
+
+    // new tentative distance of a vertex that is not settled yet
+    void set(VertexIndex idx, Dist dist, VertexIndex prev) {
+        assert(!is_visited(idx));
+        m_entries[idx] = { dist, prev, m_generation };
+    }
+
+    void mark_visited(VertexIndex idx) {
+        assert(is_reached(idx));
+        m_entries[idx].m_stamp = m_generation + 1;
+    }
+
+};
+
+enum class Algorithm {
+    Dijkstra,
+    AStar, // directs the search towards the target using Graph::estimate_distance()
+};
+
+template <Distance Dist = uint64_t>
 class Solver {
-    struct TableEntry {
-        int m_dist; // distance from source vertex
-        VertexId m_prev; // previous vertex
+    struct QueueEntry {
+        Dist m_key; // distance from source, plus the estimated distance to the target for A*
+        VertexIndex m_idx;
     };
 
     // data
-    std::unordered_map<VertexId, Vertex> m_vertices;
-    VertexId m_source;
-    std::list<VertexId> m_unvisited;
-    static constexpr int m_inf = 999;
-    std::unordered_map<VertexId, TableEntry> m_table;
+    const Graph &m_graph;
+    VertexIndex m_source;
+    VertexIndex m_target = NO_VERTEX; // the search stops once this vertex is settled, if set
+    Algorithm m_algorithm;
+    size_t m_visited_count = 0;
+    static constexpr Dist m_inf = INF_DISTANCE<Dist>;
+    SearchWorkspace<Dist> m_workspace;
+    // targets of the running query_many(), all false in between
+    std::vector<bool> m_is_target;
+    // binary heap frontier with lazy deletion: outdated entries stay in the heap and are skipped when popped
+    // kept as a plain vector instead of std::priority_queue, so reset() can clear it without freeing its storage
+    std::vector<QueueEntry> m_queue;
 
     // state
-    VertexId m_current;
-    std::vector<Edge>::const_iterator m_neighbour;
+    VertexIndex m_current = NO_VERTEX;
+    std::span<const Arc>::iterator m_neighbour;
     enum class State {
         Idle,
         NextVertex,
@@ -64,386 +1028,3653 @@ class Solver {
     friend class Renderer;
 
 public:
-    Solver(std::unordered_map<VertexId, Vertex> vertices, VertexId source)
-        : m_vertices(vertices)
-        , m_source(source)
+    // the graph is not copied, it has to outlive the solver
+    // without a target, distances to every reachable vertex are computed and A* falls back to dijkstra
+    Solver(
+        const Graph &graph,
+        VertexId source,
+        std::optional<VertexId> target = std::nullopt,
+        Algorithm algorithm = Algorithm::Dijkstra
+    )
+        : m_graph(graph)
+        , m_source(m_graph.index(source))
+        , m_target(target ? m_graph.index(*target) : NO_VERTEX)
+        , m_algorithm(algorithm)
     {
         reset();
     }
 
-    [[nodiscard]] auto get_optimal_path(VertexId dest) const {
-        std::vector<VertexId> path;
+    // a temporary graph would be gone before the first query
+    Solver(Graph &&, VertexId, std::optional<VertexId> = std::nullopt, Algorithm = Algorithm::Dijkstra) = delete;
+
+    // point-to-point query: searches until dest is settled and returns the route right away
+    [[nodiscard]] std::optional<Route<Dist>> query(VertexId dest) {
+        m_target = m_graph.index(dest);
+        reset();
+        solve();
+        return get_route(dest);
+    }
+
+    // point-to-point query from any source that only returns the distance
+    // the tables are reused, so one solver can answer any number of queries without allocating
+    [[nodiscard]] std::optional<Dist> query_distance(VertexId source, VertexId dest) {
+        m_source = m_graph.index(source);
+        m_target = m_graph.index(dest);
+        reset();
+        solve();
+        if (!is_visited(m_target)) return std::nullopt;
+        return m_workspace.dist(m_target);
+    }
+
+    // one-to-many query: searches from source until all of targets are settled and writes their distances to out,
+    // INF_DISTANCE for unreachable ones. stops as early as the farthest target allows instead of searching everything
+    void query_many(VertexId source, std::span<const VertexId> targets, std::span<Dist> out) {
+        assert(out.size() == targets.size());
+        m_source = m_graph.index(source);
+        m_target = NO_VERTEX;
+        reset();
+
+        // duplicate targets are counted once
+        m_is_target.resize(m_graph.size());
+        size_t targets_left = 0;
+        for (auto id : targets) {
+            VertexIndex idx = m_graph.index(id);
+            targets_left += !m_is_target[idx];
+            m_is_target[idx] = true;
+        }
+
+        while (targets_left > 0 && next_unvisited()) {
+            mark_visited();
+            if (m_is_target[m_current] && --targets_left == 0) break;
+
+            for (const auto &arc : m_graph.neighbours(m_current)) {
+                relax(arc);
+            }
+        }
+        m_state = State::Terminated;
+
+        for (auto &&[i, id] : std::views::enumerate(targets)) {
+            VertexIndex idx = m_graph.index(id);
+            out[i] = is_visited(idx) ? m_workspace.dist(idx) : m_inf;
+            m_is_target[idx] = false;
+        }
+    }
+
+    [[nodiscard]] std::optional<Route<Dist>> get_route(VertexId dest) const {
+        VertexIndex idx = m_graph.index(dest);
+        if (!is_visited(idx)) return std::nullopt;
+
+        Route<Dist> route { m_workspace.dist(idx), { } };
+        for (; idx != NO_VERTEX; idx = m_workspace.prev(idx)) {
+            route.m_path.push_back(m_graph.id(idx));
+        }
+        ranges::reverse(route.m_path);
+
+        return route;
+    }
+
+    [[nodiscard]] bool is_visited(VertexIndex idx) const {
+        return m_workspace.is_visited(idx);
+    }
+
+    [[nodiscard]] size_t visited_count() const {
+        return m_visited_count;
+    }
+
+    [[nodiscard]] bool is_done() const {
+        return m_state == State::Terminated;
+    }
+
+    void reset() {
+        m_state = State::Idle;
+        m_queue.clear();
+        push_queue({ estimate(m_source), m_source });
+        m_visited_count = 0;
+        m_workspace.reset(m_graph.size());
+        m_workspace.set(m_source, 0, NO_VERTEX);
+    }
+
+    // runs the search to completion in a tight loop, without going through the stepping state machine
+    void solve() {
+        // finish the vertex that is currently being stepped through
+        while (m_state == State::NextVertex || m_state == State::Visiting) {
+            next();
+        }
+
+        while (next_unvisited()) {
+            if (m_current == m_target) {
+                mark_visited();
+                break;
+            }
+
+            for (const auto &arc : m_graph.neighbours(m_current)) {
+                relax(arc);
+            }
+            mark_visited();
+        }
+
+        m_state = State::Terminated;
+    }
+
+    void next() {
+        switch (m_state) {
+            case State::Terminated:
+                ;
+                break;
+
+            case State::Idle: {
+
+                if (!next_unvisited()) {
+                    // vertices that are still unvisited at this point are unreachable from the source
+                    m_state = State::Terminated;
+                    return;
+                };
+
+                if (m_current == m_target) {
+                    mark_visited();
+                    m_state = State::Terminated;
+                    return;
+                }
+
+                m_state = State::NextVertex;
+
+            } break;
+
+            case State::NextVertex: {
+                auto neighbours = m_graph.neighbours(m_current);
+                m_neighbour = neighbours.begin();
+
+                bool no_neighbours = m_neighbour == neighbours.end();
+
+                if (no_neighbours) {
+                    mark_visited();
+                    m_state = State::Idle;
+                    return;
+                }
+
+                m_state = State::Visiting;
+
+            } break;
+
+            case State::Visiting: {
+                relax(*m_neighbour);
+                m_neighbour++;
+
+                if (m_neighbour == m_graph.neighbours(m_current).end()) {
+                    mark_visited();
+                    m_state = State::Idle;
+                    return;
+                }
+
+            } break;
+
+        }
+    }
+
+private:
+    // pops the closest vertex off the frontier into m_current, returns false if the frontier is exhausted
+    [[nodiscard]] inline bool next_unvisited() {
+        while (!m_queue.empty()) {
+            ranges::pop_heap(m_queue, std::greater{}, &QueueEntry::m_key);
+            auto [dist, idx] = m_queue.back();
+            m_queue.pop_back();
+
+            // outdated entries of a vertex are popped after its shortest one, so it is already visited
+            if (is_visited(idx)) continue;
+
+            m_current = idx;
+            return true;
+        }
+        return false;
+    }
+
+    void relax(const Arc &arc) {
+        Dist current_dist = m_workspace.dist(m_current);
+
+        auto other = arc.m_target;
+
+        if (is_visited(other)) return;
+
+        Dist dist = saturating_add(current_dist, weight_to_distance<Dist>(arc.m_weight));
+        Dist other_dist = m_workspace.dist(other);
+        if (dist < other_dist) {
+            m_workspace.set(other, dist, m_current);
+            push_queue({ saturating_add(dist, estimate(other)), other });
+        }
+
+    }
+
+    inline void push_queue(QueueEntry entry) {
+        m_queue.push_back(entry);
+        // the std heap algorithms build a max-heap, so compare with greater to get the closest vertex on top
+        ranges::push_heap(m_queue, std::greater{}, &QueueEntry::m_key);
+    }
+
+    inline void mark_visited() {
+        m_workspace.mark_visited(m_current);
+        m_visited_count++;
+    }
+
+    [[nodiscard]] inline Dist estimate(VertexIndex idx) const {
+        if (m_algorithm != Algorithm::AStar || m_target == NO_VERTEX) return 0;
+        double estimate = m_graph.estimate_distance(idx, m_target);
+        // truncating towards zero keeps the estimate admissible for integer distances
+        return estimate >= static_cast<double>(m_inf) ? m_inf : static_cast<Dist>(estimate);
+    }
+
+    [[nodiscard]] static constexpr const char *stringify_state(State state) {
+        switch (state) {
+            case State::Idle:       return "Idle";
+            case State::NextVertex: return "NextVertex";
+            case State::Visiting:   return "Visiting";
+            case State::Terminated: return "Terminated";
+        }
+        std::unreachable();
+    }
+
+};
+
+// point-to-point search that grows a forward frontier from the source and a backward frontier from the target
+// until they meet, so it settles roughly two balls of half the radius instead of one full ball
+template <Distance Dist = uint64_t>
+class BidirectionalSolver {
+    struct QueueEntry {
+        Dist m_dist;
+        VertexIndex m_idx;
+    };
+
+    struct Direction {
+        SearchWorkspace<Dist> m_workspace; // distances and previous vertices, seen from the source of this direction
+        std::vector<QueueEntry> m_queue;
+    };
+
+    const Graph &m_graph;
+    static constexpr Dist m_inf = INF_DISTANCE<Dist>;
+    Direction m_forward;
+    Direction m_backward;
+    size_t m_visited_count = 0;
+
+public:
+    // the graph is not copied, it has to outlive the solver
+    explicit BidirectionalSolver(const Graph &graph) : m_graph(graph) { }
+    explicit BidirectionalSolver(Graph &&) = delete;
+
+    [[nodiscard]] std::optional<Route<Dist>> query(VertexId source, VertexId dest) {
+        VertexIndex src = m_graph.index(source);
+        VertexIndex dst = m_graph.index(dest);
+
+        reset(m_forward, src);
+        reset(m_backward, dst);
+        m_visited_count = 0;
+
+        // length of the shortest path found so far and the vertex where it crosses from forward to backward
+        Dist best = src == dst ? 0 : m_inf;
+        VertexIndex meet = src == dst ? src : NO_VERTEX;
+
+        while (true) {
+            auto forward_top = top(m_forward);
+            auto backward_top = top(m_backward);
+            if (!forward_top || !backward_top) break;
+
+            // every path that is not yet known has to be at least as long as the sum of both frontiers
+            if (saturating_add(*forward_top, *backward_top) >= best) break;
+
+            bool forward = *forward_top <= *backward_top;
+            auto &dir = forward ? m_forward : m_backward;
+            auto &other = forward ? m_backward : m_forward;
+
+            auto [dist, idx] = pop(dir);
+            dir.m_workspace.mark_visited(idx);
+            m_visited_count++;
+
+            for (const auto &arc : forward ? m_graph.neighbours(idx) : m_graph.incoming(idx)) {
+                if (dir.m_workspace.is_visited(arc.m_target)) continue;
+
+                Dist arc_dist = saturating_add(dist, weight_to_distance<Dist>(arc.m_weight));
+                if (arc_dist < dir.m_workspace.dist(arc.m_target)) {
+                    dir.m_workspace.set(arc.m_target, arc_dist, idx);
+                    push(dir, { arc_dist, arc.m_target });
+                }
+
+                Dist through = saturating_add(arc_dist, other.m_workspace.dist(arc.m_target));
+                if (through < best) {
+                    best = through;
+                    meet = arc.m_target;
+                }
+            }
+        }
+
+        if (meet == NO_VERTEX) return std::nullopt;
+
+        Route<Dist> route { best, { } };
+        for (VertexIndex idx = meet; idx != NO_VERTEX; idx = m_forward.m_workspace.prev(idx)) {
+            route.m_path.push_back(m_graph.id(idx));
+        }
+        ranges::reverse(route.m_path);
+        for (VertexIndex idx = m_backward.m_workspace.prev(meet); idx != NO_VERTEX; idx = m_backward.m_workspace.prev(idx)) {
+            route.m_path.push_back(m_graph.id(idx));
+        }
+
+        return route;
+    }
+
+    // vertices settled by the last query, in both directions
+    [[nodiscard]] size_t visited_count() const {
+        return m_visited_count;
+    }
+
+private:
+    void reset(Direction &dir, VertexIndex source) const {
+        dir.m_workspace.reset(m_graph.size());
+        dir.m_queue.clear();
+        dir.m_workspace.set(source, 0, NO_VERTEX);
+        push(dir, { 0, source });
+    }
+
+    // distance of the closest unvisited vertex on the frontier, after dropping outdated entries
+    [[nodiscard]] static std::optional<Dist> top(Direction &dir) {
+        while (!dir.m_queue.empty() && dir.m_workspace.is_visited(dir.m_queue.front().m_idx)) {
+            pop(dir);
+        }
+        if (dir.m_queue.empty()) return std::nullopt;
+        return dir.m_queue.front().m_dist;
+    }
+
+    static QueueEntry pop(Direction &dir) {
+        ranges::pop_heap(dir.m_queue, std::greater{}, &QueueEntry::m_dist);
+        auto entry = dir.m_queue.back();
+        dir.m_queue.pop_back();
+        return entry;
+    }
+
+    static void push(Direction &dir, QueueEntry entry) {
+        dir.m_queue.push_back(entry);
+        ranges::push_heap(dir.m_queue, std::greater{}, &QueueEntry::m_dist);
+    }
+
+};
+
+struct HierarchyArc {
+    VertexIndex m_target;
+    Weight m_weight; // saturates for shortcuts that would be longer
+    VertexIndex m_middle; // vertex that this shortcut bypasses, NO_VERTEX for arcs of the original graph
+};
+
+// contraction hierarchy over a Graph
+// vertices are contracted one by one, least important first, and shortcut arcs are added wherever a shortest
+// path between the remaining vertices went through the contracted one. a query then only has to search upwards,
+// towards vertices contracted later, from both of its ends
+template <Distance Dist = uint64_t>
+class ContractionHierarchy {
+    struct BuildArc {
+        VertexIndex m_other;
+        Weight m_weight;
+        VertexIndex m_middle;
+    };
+
+    template <typename T>
+    struct BasicQueueEntry {
+        T m_dist;
+        VertexIndex m_idx;
+    };
+    using QueueEntry = BasicQueueEntry<Dist>;
+    using BuildQueueEntry = BasicQueueEntry<Weight>;
+    using OrderEntry = BasicQueueEntry<int>; // contraction priority
+
+    // per direction query state, only the vertices touched by the previous query are reset
+    struct Direction {
+        std::vector<Dist> m_dist;
+        std::vector<VertexIndex> m_parent;
+        std::vector<size_t> m_parent_arc; // index into the up or down arcs
+        std::vector<VertexIndex> m_touched;
+        std::vector<QueueEntry> m_queue;
+    };
+
+    const Graph &m_graph;
+    static constexpr Dist m_inf = INF_DISTANCE<Dist>;
+    static constexpr Weight m_weight_inf = INF_DISTANCE<Weight>;
+    // witness searches give up after settling this many vertices and add a shortcut that might be unnecessary
+    static constexpr size_t m_witness_settle_limit = 100;
+    static constexpr uint32_t m_file_magic = 0x48434650; // "PFCH"
+    static constexpr uint32_t m_file_version = 3;
+
+    std::vector<VertexIndex> m_rank; // position of each vertex in the contraction order
+    // arcs from vertex i to higher ranked vertices are m_up_arcs[m_up_offsets[i], m_up_offsets[i+1])
+    std::vector<size_t> m_up_offsets;
+    std::vector<HierarchyArc> m_up_arcs;
+    // arcs from higher ranked vertices into vertex i, m_target is the tail of the arc
+    std::vector<size_t> m_down_offsets;
+    std::vector<HierarchyArc> m_down_arcs;
+
+    Direction m_forward;
+    Direction m_backward;
+    size_t m_visited_count = 0;
+
+public:
+    // contracts the whole graph, which is expensive, see save() and load()
+    // the graph is not copied, it has to outlive the hierarchy
+    explicit ContractionHierarchy(const Graph &graph) : m_graph(graph) {
+        contract();
+        init_query_state();
+    }
+    explicit ContractionHierarchy(Graph &&) = delete;
+
+    [[nodiscard]] std::optional<Route<Dist>> query(VertexId source, VertexId dest) {
+        VertexIndex src = m_graph.index(source);
+        VertexIndex dst = m_graph.index(dest);
+
+        clear(m_forward);
+        clear(m_backward);
+        update(m_forward, src, 0, NO_VERTEX, 0);
+        update(m_backward, dst, 0, NO_VERTEX, 0);
+        m_visited_count = 0;
+
+        Dist best = m_inf;
+        VertexIndex meet = NO_VERTEX;
+
+        while (true) {
+            auto forward_top = top(m_forward);
+            auto backward_top = top(m_backward);
+
+            // a direction is done once nothing on its frontier can improve the best path
+            bool forward_live = forward_top && *forward_top < best;
+            bool backward_live = backward_top && *backward_top < best;
+            if (!forward_live && !backward_live) break;
+
+            bool forward = forward_live && (!backward_live || *forward_top <= *backward_top);
+            auto &dir = forward ? m_forward : m_backward;
+            auto &other = forward ? m_backward : m_forward;
+            auto &offsets = forward ? m_up_offsets : m_down_offsets;
+            auto &arcs = forward ? m_up_arcs : m_down_arcs;
+
+            auto [dist, idx] = pop(dir);
+            m_visited_count++;
+
+            Dist through = saturating_add(dist, other.m_dist[idx]);
+            if (through < best) {
+                best = through;
+                meet = idx;
+            }
+
+            for (size_t i = offsets[idx]; i < offsets[idx+1]; ++i) {
+                auto &arc = arcs[i];
+                Dist arc_dist = saturating_add(dist, weight_to_distance<Dist>(arc.m_weight));
+                if (arc_dist < dir.m_dist[arc.m_target]) {
+                    update(dir, arc.m_target, arc_dist, idx, i);
+                }
+            }
+        }
+
+        if (meet == NO_VERTEX) return std::nullopt;
+
+        Route<Dist> route { best, { } };
+
+        // walk back from the meeting vertex to the source, then unpack the shortcuts front to back
+        std::vector<size_t> up_path;
+        for (VertexIndex idx = meet; m_forward.m_parent[idx] != NO_VERTEX; idx = m_forward.m_parent[idx]) {
+            up_path.push_back(m_forward.m_parent_arc[idx]);
+        }
+
+        std::vector<VertexIndex> path { src };
+        for (VertexIndex idx = src; auto arc_idx : up_path | std::views::reverse) {
+            auto &arc = m_up_arcs[arc_idx];
+            unpack(idx, arc.m_target, arc.m_weight, arc.m_middle, path);
+            idx = arc.m_target;
+        }
+
+        for (VertexIndex idx = meet; m_backward.m_parent[idx] != NO_VERTEX; ) {
+            auto &arc = m_down_arcs[m_backward.m_parent_arc[idx]];
+            VertexIndex next = m_backward.m_parent[idx];
+            unpack(idx, next, arc.m_weight, arc.m_middle, path);
+            idx = next;
+        }
+
+        for (auto idx : path) {
+            route.m_path.push_back(m_graph.id(idx));
+        }
+
+        return route;
+    }
+
+    // dense sources x targets distance matrix from one upward search per source and one per target, instead of a
+    // query per pair: the search of every target leaves (target, distance) entries in buckets at the vertices it
+    // settles, the search of a source then only has to scan the buckets of the vertices it settles
+    [[nodiscard]] DistanceMatrix<Dist> distance_matrix(std::span<const VertexId> sources, std::span<const VertexId> targets) {
+        struct BucketEntry {
+            VertexIndex m_idx;
+            uint32_t m_column;
+            Dist m_dist;
+        };
+
+        DistanceMatrix<Dist> matrix { sources.size(), targets.size(), { } };
+        matrix.m_dists.assign(sources.size() * targets.size(), m_inf);
+        m_visited_count = 0;
+
+        // all buckets in one array, sorted by the vertex they belong to
+        std::vector<BucketEntry> buckets;
+        for (auto &&[column, id] : std::views::enumerate(targets)) {
+            search_up(m_backward, m_graph.index(id), [&](VertexIndex idx, Dist dist) {
+                buckets.push_back({ idx, static_cast<uint32_t>(column), dist });
+            });
+        }
+        ranges::sort(buckets, { }, &BucketEntry::m_idx);
+
+        for (auto &&[row, id] : std::views::enumerate(sources)) {
+            auto dists = matrix.row(row);
+            search_up(m_forward, m_graph.index(id), [&](VertexIndex idx, Dist dist) {
+                for (auto &entry : ranges::equal_range(buckets, idx, { }, &BucketEntry::m_idx)) {
+                    dists[entry.m_column] = std::min(dists[entry.m_column], saturating_add(dist, entry.m_dist));
+                }
+            });
+        }
+
+        return matrix;
+    }
+
+    // vertices settled by the last query, in both directions
+    [[nodiscard]] size_t visited_count() const {
+        return m_visited_count;
+    }
+
+    [[nodiscard]] size_t shortcut_count() const {
+        return ranges::count_if(m_up_arcs, [](const HierarchyArc &arc) { return arc.m_middle != NO_VERTEX; })
+             + ranges::count_if(m_down_arcs, [](const HierarchyArc &arc) { return arc.m_middle != NO_VERTEX; });
+    }
+
+    [[nodiscard]] bool save(const char *filename) const {
+        FILE *file = std::fopen(filename, "wb");
+        if (file == nullptr) return false;
+
+        uint64_t vertex_count = m_graph.size();
+        uint64_t arc_count = m_graph.arc_count();
+        uint64_t fingerprint = m_graph.fingerprint();
+        bool ok = write_value(file, m_file_magic)
+            && write_value(file, m_file_version)
+            && write_value(file, vertex_count)
+            && write_value(file, arc_count)
+            && write_value(file, fingerprint)
+            && write_vector(file, m_rank)
+            && write_vector(file, m_up_offsets)
+            && write_vector(file, m_up_arcs)
+            && write_vector(file, m_down_offsets)
+            && write_vector(file, m_down_arcs);
+
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // loads a hierarchy written by save() for the same graph, nullopt if the file is missing or doesn't match
+    // the graph has to be the same down to the vertex order, a permuted graph has other indices
+    static std::optional<ContractionHierarchy> load(Graph &&, const char *) = delete;
+    [[nodiscard]] static std::optional<ContractionHierarchy> load(const Graph &graph, const char *filename) {
+        FILE *file = std::fopen(filename, "rb");
+        if (file == nullptr) return std::nullopt;
+
+        ContractionHierarchy ch(graph, Loaded { });
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint64_t vertex_count = 0;
+        uint64_t arc_count = 0;
+        uint64_t fingerprint = 0;
+
+        bool ok = read_value(file, magic) && magic == m_file_magic
+            && read_value(file, version) && version == m_file_version
+            && read_value(file, vertex_count) && vertex_count == graph.size()
+            && read_value(file, arc_count) && arc_count == graph.arc_count()
+            && read_value(file, fingerprint) && fingerprint == graph.fingerprint()
+            && read_vector(file, ch.m_rank) && ch.m_rank.size() == vertex_count
+            && read_vector(file, ch.m_up_offsets) && ch.m_up_offsets.size() == vertex_count + 1
+            && read_vector(file, ch.m_up_arcs) && ch.m_up_arcs.size() == ch.m_up_offsets.back()
+            && read_vector(file, ch.m_down_offsets) && ch.m_down_offsets.size() == vertex_count + 1
+            && read_vector(file, ch.m_down_arcs) && ch.m_down_arcs.size() == ch.m_down_offsets.back();
+
+        std::fclose(file);
+        if (!ok) return std::nullopt;
+
+        ch.init_query_state();
+        return ch;
+    }
+
+private:
+    struct Loaded { };
+    ContractionHierarchy(const Graph &graph, Loaded) : m_graph(graph) { }
+
+    void contract() {
+        size_t n = m_graph.size();
+
+        // remaining graph, arcs to contracted vertices are removed as they go
+        std::vector<std::vector<BuildArc>> out(n);
+        std::vector<std::vector<BuildArc>> in(n);
+        for (VertexIndex idx = 0; idx < n; ++idx) {
+            for (auto &arc : m_graph.neighbours(idx)) {
+                add_build_arc(out, in, idx, { arc.m_target, arc.m_weight, NO_VERTEX });
+            }
+        }
+
+        std::vector<std::vector<HierarchyArc>> up(n);
+        std::vector<std::vector<HierarchyArc>> down(n);
+        std::vector<int> contracted_neighbours(n, 0);
+        std::vector<int> level(n, 0);
+        std::vector<int> priority(n);
+        std::vector<bool> contracted(n, false);
+
+        // witness search workspace
+        std::vector<Weight> dist(n, m_weight_inf);
+        std::vector<VertexIndex> touched;
+        std::vector<BuildQueueEntry> queue;
+        std::vector<bool> is_target(n, false);
+        size_t target_count = 0;
+
+        // runs a dijkstra from source in the remaining graph without skip, until all vertices marked in
+        // is_target are settled or the limit is reached
+        auto witness_search = [&](VertexIndex source, VertexIndex skip, Weight limit) {
+            for (auto idx : touched) dist[idx] = m_weight_inf;
+            touched.clear();
+            queue.clear();
+
+            dist[source] = 0;
+            touched.push_back(source);
+            queue.push_back({ 0, source });
+            size_t settled = 0;
+            size_t targets_left = target_count;
+
+            while (!queue.empty() && settled < m_witness_settle_limit && targets_left > 0) {
+                ranges::pop_heap(queue, std::greater{}, &BuildQueueEntry::m_dist);
+                auto [d, idx] = queue.back();
+                queue.pop_back();
+                if (d > dist[idx]) continue;
+                if (d > limit) break;
+                settled++;
+                if (is_target[idx]) targets_left--;
+
+                for (auto &arc : out[idx]) {
+                    if (arc.m_other == skip) continue;
+                    Weight arc_dist = saturating_add(d, arc.m_weight);
+                    if (arc_dist < dist[arc.m_other]) {
+                        if (dist[arc.m_other] == m_weight_inf) touched.push_back(arc.m_other);
+                        dist[arc.m_other] = arc_dist;
+                        queue.push_back({ arc_dist, arc.m_other });
+                        ranges::push_heap(queue, std::greater{}, &BuildQueueEntry::m_dist);
+                    }
+                }
+            }
+        };
+
+        // shortcuts needed to contract vtx, in the form (from, arc)
+        std::vector<std::pair<VertexIndex, BuildArc>> shortcuts;
+        auto find_shortcuts = [&](VertexIndex vtx) {
+            shortcuts.clear();
+            if (out[vtx].empty()) return;
+            Weight max_out = ranges::max(out[vtx], { }, &BuildArc::m_weight).m_weight;
+
+            for (auto &outgoing : out[vtx]) is_target[outgoing.m_other] = true;
+            target_count = out[vtx].size();
+
+            for (auto &incoming : in[vtx]) {
+                VertexIndex from = incoming.m_other;
+                witness_search(from, vtx, saturating_add(incoming.m_weight, max_out));
+
+                for (auto &outgoing : out[vtx]) {
+                    VertexIndex to = outgoing.m_other;
+                    if (to == from) continue;
+
+                    Weight via = saturating_add(incoming.m_weight, outgoing.m_weight);
+                    if (dist[to] <= via) continue;
+
+                    shortcuts.push_back({ from, { to, via, vtx } });
+                }
+            }
+
+            for (auto &outgoing : out[vtx]) is_target[outgoing.m_other] = false;
+        };
+
+        // edge difference (shortcuts added minus arcs removed), plus the contracted neighbours and the level in
+        // the hierarchy, so the contraction spreads evenly over the graph instead of eating into one region
+        auto compute_priority = [&](VertexIndex vtx) {
+            find_shortcuts(vtx);
+            int edge_difference = static_cast<int>(shortcuts.size()) - static_cast<int>(in[vtx].size() + out[vtx].size());
+            return 2 * edge_difference + contracted_neighbours[vtx] + level[vtx];
+        };
+
+        std::vector<OrderEntry> order; // min-heap of (priority, vertex)
+        order.reserve(n);
+        for (VertexIndex idx = 0; idx < n; ++idx) {
+            priority[idx] = compute_priority(idx);
+            order.push_back({ priority[idx], idx });
+        }
+        ranges::make_heap(order, std::greater{}, &OrderEntry::m_dist);
+
+        m_rank.assign(n, NO_VERTEX);
+        VertexIndex rank = 0;
+
+        while (!order.empty()) {
+            ranges::pop_heap(order, std::greater{}, &OrderEntry::m_dist);
+            auto [prio, vtx] = order.back();
+            order.pop_back();
+            if (contracted[vtx] || prio != priority[vtx]) continue;
+
+            // lazy update: the priority may have grown since it was queued
+            priority[vtx] = compute_priority(vtx);
+            if (!order.empty() && priority[vtx] > order.front().m_dist) {
+                order.push_back({ priority[vtx], vtx });
+                ranges::push_heap(order, std::greater{}, &OrderEntry::m_dist);
+                continue;
+            }
+
+            // shortcuts are still up to date from compute_priority()
+            m_rank[vtx] = rank++;
+            contracted[vtx] = true;
+
+            for (auto &arc : out[vtx]) {
+                up[vtx].push_back({ arc.m_other, arc.m_weight, arc.m_middle });
+                std::erase_if(in[arc.m_other], [&](const BuildArc &a) { return a.m_other == vtx; });
+            }
+            for (auto &arc : in[vtx]) {
+                down[vtx].push_back({ arc.m_other, arc.m_weight, arc.m_middle });
+                std::erase_if(out[arc.m_other], [&](const BuildArc &a) { return a.m_other == vtx; });
+            }
+
+            for (auto &[from, arc] : shortcuts) {
+                add_build_arc(out, in, from, arc);
+            }
+
+            std::vector<VertexIndex> neighbours;
+            for (auto &arc : out[vtx]) neighbours.push_back(arc.m_other);
+            for (auto &arc : in[vtx]) neighbours.push_back(arc.m_other);
+            ranges::sort(neighbours);
+            auto duplicates = ranges::unique(neighbours);
+            neighbours.erase(duplicates.begin(), duplicates.end());
+
+            out[vtx] = { };
+            in[vtx] = { };
+
+            for (auto other : neighbours) {
+                contracted_neighbours[other]++;
+                level[other] = std::max(level[other], level[vtx] + 1);
+                priority[other] = compute_priority(other);
+                order.push_back({ priority[other], other });
+                ranges::push_heap(order, std::greater{}, &OrderEntry::m_dist);
+            }
+        }
+
+        flatten(up, m_up_offsets, m_up_arcs);
+        flatten(down, m_down_offsets, m_down_arcs);
+    }
+
+    // adds the arc from -> arc.m_other, keeping only the shorter one of parallel arcs
+    static void add_build_arc(
+        std::vector<std::vector<BuildArc>> &out,
+        std::vector<std::vector<BuildArc>> &in,
+        VertexIndex from,
+        BuildArc arc
+    ) {
+        if (from == arc.m_other) return;
+
+        auto existing = ranges::find(out[from], arc.m_other, &BuildArc::m_other);
+        if (existing != out[from].end()) {
+            if (existing->m_weight <= arc.m_weight) return;
+            *existing = arc;
+            *ranges::find(in[arc.m_other], from, &BuildArc::m_other) = { from, arc.m_weight, arc.m_middle };
+            return;
+        }
+
+        out[from].push_back(arc);
+        in[arc.m_other].push_back({ from, arc.m_weight, arc.m_middle });
+    }
+
+    static void flatten(
+        const std::vector<std::vector<HierarchyArc>> &lists,
+        std::vector<size_t> &offsets,
+        std::vector<HierarchyArc> &arcs
+    ) {
+        offsets.assign(1, 0);
+        for (auto &list : lists) {
+            arcs.insert(arcs.end(), list.begin(), list.end());
+            offsets.push_back(arcs.size());
+        }
+    }
+
+    // appends the original vertices of the (shortcut) arc from -> to to path, excluding from
+    void unpack(VertexIndex from, VertexIndex to, Weight weight, VertexIndex middle, std::vector<VertexIndex> &path) const {
+        struct Segment {
+            VertexIndex m_from;
+            VertexIndex m_to;
+            Weight m_weight;
+            VertexIndex m_middle;
+        };
+
+        // explicit stack, shortcuts can nest as deep as the hierarchy
+        std::vector<Segment> stack { { from, to, weight, middle } };
+        while (!stack.empty()) {
+            auto seg = stack.back();
+            stack.pop_back();
+
+            if (seg.m_middle == NO_VERTEX) {
+                path.push_back(seg.m_to);
+                continue;
+            }
+
+            // the middle vertex was contracted before both ends, so both halves are stored at it
+            auto first = find_arc(m_down_offsets, m_down_arcs, seg.m_middle, seg.m_from);
+            auto second = find_arc(m_up_offsets, m_up_arcs, seg.m_middle, seg.m_to);
+            assert(saturating_add(first.m_weight, second.m_weight) == seg.m_weight);
+
+            stack.push_back({ seg.m_middle, seg.m_to, second.m_weight, second.m_middle });
+            stack.push_back({ seg.m_from, seg.m_middle, first.m_weight, first.m_middle });
+        }
+    }
+
+    [[nodiscard]] static const HierarchyArc &find_arc(
+        const std::vector<size_t> &offsets,
+        const std::vector<HierarchyArc> &arcs,
+        VertexIndex idx,
+        VertexIndex target
+    ) {
+        auto list = std::span(arcs).subspan(offsets[idx], offsets[idx+1] - offsets[idx]);
+        auto arc = ranges::find(list, target, &HierarchyArc::m_target);
+        assert(arc != list.end());
+        return *arc;
+    }
+
+    void init_query_state() {
+        for (auto dir : { &m_forward, &m_backward }) {
+            dir->m_dist.assign(m_graph.size(), m_inf);
+            dir->m_parent.assign(m_graph.size(), NO_VERTEX);
+            dir->m_parent_arc.assign(m_graph.size(), 0);
+        }
+    }
+
+    static void clear(Direction &dir) {
+        for (auto idx : dir.m_touched) {
+            dir.m_dist[idx] = m_inf;
+            dir.m_parent[idx] = NO_VERTEX;
+        }
+        dir.m_touched.clear();
+        dir.m_queue.clear();
+    }
+
+    static void update(Direction &dir, VertexIndex idx, Dist dist, VertexIndex parent, size_t parent_arc) {
+        if (dir.m_dist[idx] == m_inf) dir.m_touched.push_back(idx);
+        dir.m_dist[idx] = dist;
+        dir.m_parent[idx] = parent;
+        dir.m_parent_arc[idx] = parent_arc;
+        dir.m_queue.push_back({ dist, idx });
+        ranges::push_heap(dir.m_queue, std::greater{}, &QueueEntry::m_dist);
+    }
+
+    // settles everything reachable from start in the upward graph of a direction, calls settled(idx, dist) for each
+    template <typename Fn>
+    void search_up(Direction &dir, VertexIndex start, Fn settled) {
+        bool forward = &dir == &m_forward;
+        auto &offsets = forward ? m_up_offsets : m_down_offsets;
+        auto &arcs = forward ? m_up_arcs : m_down_arcs;
+
+        clear(dir);
+        update(dir, start, 0, NO_VERTEX, 0);
+
+        while (top(dir)) {
+            auto [dist, idx] = pop(dir);
+            m_visited_count++;
+            settled(idx, dist);
+
+            for (size_t i = offsets[idx]; i < offsets[idx+1]; ++i) {
+                auto &arc = arcs[i];
+                Dist arc_dist = saturating_add(dist, weight_to_distance<Dist>(arc.m_weight));
+                if (arc_dist < dir.m_dist[arc.m_target]) {
+                    update(dir, arc.m_target, arc_dist, idx, i);
+                }
+            }
+        }
+    }
+
+    // distance of the closest vertex on the frontier, after dropping outdated entries
+    [[nodiscard]] static std::optional<Dist> top(Direction &dir) {
+        while (!dir.m_queue.empty() && dir.m_queue.front().m_dist > dir.m_dist[dir.m_queue.front().m_idx]) {
+            pop(dir);
+        }
+        if (dir.m_queue.empty()) return std::nullopt;
+        return dir.m_queue.front().m_dist;
+    }
+
+    static QueueEntry pop(Direction &dir) {
+        ranges::pop_heap(dir.m_queue, std::greater{}, &QueueEntry::m_dist);
+        auto entry = dir.m_queue.back();
+        dir.m_queue.pop_back();
+        return entry;
+    }
+
+    template <typename T>
+    [[nodiscard]] static bool write_value(FILE *file, const T &value) {
+        return std::fwrite(&value, sizeof(T), 1, file) == 1;
+    }
+
+    template <typename T>
+    [[nodiscard]] static bool write_vector(FILE *file, const std::vector<T> &vec) {
+        uint64_t size = vec.size();
+        return write_value(file, size) && std::fwrite(vec.data(), sizeof(T), vec.size(), file) == vec.size();
+    }
+
+    template <typename T>
+    [[nodiscard]] static bool read_value(FILE *file, T &value) {
+        return std::fread(&value, sizeof(T), 1, file) == 1;
+    }
+
+    template <typename T>
+    [[nodiscard]] static bool read_vector(FILE *file, std::vector<T> &vec) {
+        uint64_t size = 0;
+        if (!read_value(file, size)) return false;
+        vec.resize(size);
+        return std::fread(vec.data(), sizeof(T), size, file) == size;
+    }
+
+};
+
+class Renderer {
+    const Solver<> &m_solver;
+    // geometry of contracted edges, drawn instead of straight lines if set
+    const PolylineStore *m_polylines;
+    static constexpr float m_fontsize = 50;
+    static constexpr Vector2 m_draw_offset { 0, 0 };
+
+public:
+    Renderer(const Solver<> &solver, const PolylineStore *polylines = nullptr)
+        : m_solver(solver)
+        , m_polylines(polylines)
+    { }
+
+    void draw() const {
+        auto &graph = m_solver.m_graph;
+
+        for (VertexIndex idx = 0; idx < graph.size(); ++idx) {
+            draw_neighbours(idx);
+        }
+
+        if (m_solver.m_state == Solver<>::State::Visiting) {
+            auto other_pos = graph.position(m_solver.m_neighbour->m_target);
+            auto pos = graph.position(m_solver.m_current);
+            DrawLineEx(convert_vertex_pos(pos), convert_vertex_pos(other_pos), 5, GREEN);
+        }
+
+        for (VertexIndex idx = 0; idx < graph.size(); ++idx) {
+            draw_vertex(idx);
+        }
+
+        float radius = 10;
+        DrawCircleV(convert_vertex_pos(graph.position(m_solver.m_source)), radius, RED);
+
+        draw_ui();
+
+    }
+
+private:
+    [[nodiscard]] static Vector2 convert_vertex_pos(Vector2 pos) {
+        return pos * Vector2 { WIDTH, HEIGHT };
+    }
+
+    void draw_vertex(VertexIndex idx) const {
+        auto &graph = m_solver.m_graph;
+        VertexId id = graph.id(idx);
+
+        auto pos = convert_vertex_pos(graph.position(idx));
+        auto color = idx == m_solver.m_current ? RED : BLUE;
+        if (idx != m_solver.m_current && m_solver.is_visited(idx))
+            color = DARKBLUE;
+
+        if (m_solver.m_state == Solver<>::State::Visiting) {
+            auto neighbour = m_solver.m_neighbour->m_target;
+            if (idx == neighbour)
+                color = GREEN;
+        }
+
+        if (m_solver.m_state == Solver<>::State::Terminated && m_solver.m_target != NO_VERTEX) {
+            auto route = m_solver.get_route(graph.id(m_solver.m_target));
+            bool exists = route && ranges::find(route->m_path, id) != route->m_path.end();
+            if (exists) {
+                color = PURPLE;
+            }
+        }
+
+        float radius = 30;
+        DrawCircleV(pos, radius, color);
+
+        float fontsize = 50;
+        draw_text_centered(std::format("{}", id), pos, fontsize, WHITE);
+    }
+
+    void draw_ui() const {
+
+        DrawText(
+            std::format("visited: {}/{}", m_solver.visited_count(), m_solver.m_graph.size()).c_str(),
+            0,
+            0,
+            m_fontsize,
+            WHITE
+        );
+
+        DrawText(
+            std::format("state: {}", m_solver.stringify_state(m_solver.m_state)).c_str(),
+            0,
+            m_fontsize,
+            m_fontsize,
+            WHITE
+        );
+
+        draw_distance_table({ 0, m_fontsize*3 });
+    }
+
+    void draw_distance_table(Vector2 pos) const {
+        auto &graph = m_solver.m_graph;
+
+        auto &workspace = m_solver.m_workspace;
+
+        for (VertexIndex idx = 0; idx < graph.size(); ++idx) {
+            VertexId id = graph.id(idx);
+            VertexId prev = workspace.prev(idx) == NO_VERTEX ? -1 : graph.id(workspace.prev(idx));
+            auto dist = workspace.dist(idx) == m_solver.m_inf ? "inf" : std::format("{}", workspace.dist(idx));
+
+            DrawText(
+                std::format("{}: {} {}", id, dist, prev).c_str(),
+                pos.x,
+                m_fontsize * idx + pos.y,
+                m_fontsize,
+                WHITE
+            );
+
+        }
+    }
+
+    void draw_neighbours(VertexIndex idx) const {
+        auto &graph = m_solver.m_graph;
+        auto vertex_pos = convert_vertex_pos(graph.position(idx));
+
+        for (const auto &arc : graph.neighbours(idx)) {
+
+            auto pos = convert_vertex_pos(graph.position(arc.m_target));
+
+            auto from = vertex_pos;
+            if (m_polylines != nullptr) {
+                for (auto interior : m_polylines->interior_positions(graph.id(idx), graph.id(arc.m_target))) {
+                    auto interior_pos = convert_vertex_pos(interior);
+                    DrawLineEx(from, interior_pos, 3, GRAY);
+                    from = interior_pos;
+                }
+            }
+            DrawLineEx(from, pos, 3, GRAY);
+
+            // TODO:
+            // auto diff = pos - vertex_pos;
+            // float dist = Vector2Length(diff) / 2.0f;
+            // auto line_middle = vertex_pos + Vector2Normalize(diff) * dist;
+            // float fontsize = 50;
+            // draw_text_centered(std::format("{}", arc.m_weight), line_middle, fontsize, WHITE);
+
+        }
+
+    }
+
+};
+
+template <Distance Dist = uint64_t>
+[[nodiscard]] static std::optional<Route<Dist>> shortest_path(const Graph &graph, VertexId source, VertexId dest) {
+    Solver<Dist> solver(graph, source);
+    return solver.query(dest);
+}
+
+[[nodiscard]] static unsigned default_thread_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// threads parallel_for uses for count indices, at least 1 even for a thread_count of 0
+// per-thread state has to be sized with this, not with thread_count
+[[nodiscard]] static unsigned worker_count(size_t count, unsigned thread_count) {
+    return std::max<size_t>(1, std::min<size_t>(thread_count, count));
+}
+
+// calls fn(index, worker) for every index in [0, count) on up to thread_count threads, in no particular order
+// worker is in [0, worker_count(count, thread_count)) and identifies the calling thread, for per-thread state
+template <typename Fn>
+static void parallel_for(size_t count, unsigned thread_count, Fn fn) {
+    thread_count = worker_count(count, thread_count);
+    if (thread_count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i, 0u);
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    auto work = [&](unsigned worker) {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count; ) {
+            fn(i, worker);
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    for (unsigned worker = 1; worker < thread_count; ++worker) {
+        threads.emplace_back(work, worker);
+    }
+    work(0);
+}
+
+// shortest distances for many independent (source, dest) pairs against one graph, spread over thread_count threads
+// the graph is only read, every thread reuses one solver as its workspace for all of its queries
+// results are in the order of queries, nullopt if dest is unreachable
+template <Distance Dist = uint64_t>
+[[nodiscard]] static std::vector<std::optional<Dist>> batch_distances(
+    const Graph &graph,
+    std::span<const std::pair<VertexId, VertexId>> queries,
+    unsigned thread_count = default_thread_count(),
+    Algorithm algorithm = Algorithm::Dijkstra
+) {
+    std::vector<std::optional<Dist>> distances(queries.size());
+    if (queries.empty()) return distances;
+
+    // unknown ids throw here on the calling thread, an exception in a worker would terminate the program
+    for (auto [source, dest] : queries) {
+        (void)graph.index(source);
+        (void)graph.index(dest);
+    }
+
+    // created on the first query of each thread, so threads that get no work don't allocate
+    std::vector<std::optional<Solver<Dist>>> solvers(worker_count(queries.size(), thread_count));
+
+    parallel_for(queries.size(), thread_count, [&](size_t i, unsigned worker) {
+        auto [source, dest] = queries[i];
+        auto &solver = solvers[worker];
+        if (!solver) {
+            solver.emplace(graph, source, dest, algorithm);
+        }
+        distances[i] = solver->query_distance(source, dest);
+    });
+
+    return distances;
+}
+
+// shortest distances from every source to every target, e.g. depots x customers for a vehicle routing solver
+// one search per source that stops once all targets are settled, spread over thread_count threads
+template <Distance Dist = uint64_t>
+[[nodiscard]] static DistanceMatrix<Dist> distance_matrix(
+    const Graph &graph,
+    std::span<const VertexId> sources,
+    std::span<const VertexId> targets,
+    unsigned thread_count = default_thread_count()
+) {
+    DistanceMatrix<Dist> matrix { sources.size(), targets.size(), { } };
+    matrix.m_dists.assign(sources.size() * targets.size(), INF_DISTANCE<Dist>);
+    if (sources.empty()) return matrix;
+
+    // unknown ids throw here on the calling thread, an exception in a worker would terminate the program
+    for (auto id : sources) (void)graph.index(id);
+    for (auto id : targets) (void)graph.index(id);
+
+    std::vector<std::optional<Solver<Dist>>> solvers(worker_count(sources.size(), thread_count));
+
+    parallel_for(sources.size(), thread_count, [&](size_t row, unsigned worker) {
+        auto &solver = solvers[worker];
+        if (!solver) {
+            solver.emplace(graph, sources[row]);
+        }
+        solver->query_many(sources[row], targets, matrix.row(row));
+    });
+
+    return matrix;
+}
+
+[[nodiscard]] static double random_number() {
+    std::mt19937 rng(std::random_device{}());
+    return static_cast<double>(rng()) / rng.max();
+}
+
+[[nodiscard]] static std::unordered_map<VertexId, Vertex> generate_random_vertices(int n) {
+    int max_weight = 10;
+    std::unordered_map<VertexId, Vertex> verts;
+
+    std::vector<VertexId> nodes;
+    nodes.resize(n);
+    ranges::iota(nodes, 1);
+
+    for (auto &node : nodes) {
+        Vector2 pos { static_cast<float>(random_number()), static_cast<float>(random_number()) };
+        verts[node] = { node, { }, pos };
+
+    }
+
+    for (auto &node : nodes) {
+
+        std::vector<Edge> neighbours;
+        for (auto &other : nodes) {
+            if (other != node)
+                neighbours.push_back({ other, static_cast<Weight>(random_number() * static_cast<double>(max_weight)) });
+        }
+
+        verts[node].m_neighbours = neighbours;
+
+    }
+
+    return verts;
+}
+
+// grid with edges between horizontally and vertically adjacent vertices, ids are assigned row by row
+[[nodiscard]] static std::unordered_map<VertexId, Vertex> generate_grid_vertices(int width, int height) {
+    Weight max_weight = 10;
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<Weight> weight(1, max_weight);
+
+    std::unordered_map<VertexId, Vertex> verts;
+    verts.reserve(width * height);
+
+    auto id_at = [&](int x, int y) -> VertexId { return static_cast<VertexId>(y) * width + x + 1; };
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            VertexId id = id_at(x, y);
+            Vector2 pos { (x + 0.5f) / width, (y + 0.5f) / height };
+            verts[id] = { id, { }, pos };
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            VertexId id = id_at(x, y);
+
+            if (x+1 < width) {
+                Weight w = weight(rng);
+                verts[id].m_neighbours.push_back({ id_at(x+1, y), w });
+                verts[id_at(x+1, y)].m_neighbours.push_back({ id, w });
+            }
+
+            if (y+1 < height) {
+                Weight w = weight(rng);
+                verts[id].m_neighbours.push_back({ id_at(x, y+1), w });
+                verts[id_at(x, y+1)].m_neighbours.push_back({ id, w });
+            }
+        }
+    }
+
+    return verts;
+}
+
+[[nodiscard]] static auto xml_get_child_elements(tinyxml2::XMLElement *elem, const char *name) {
+    assert(elem != nullptr);
+
+    std::vector<tinyxml2::XMLElement*> elems;
+
+    tinyxml2::XMLElement *node = elem->FirstChildElement(name);
+    while (node != nullptr) {
+        elems.push_back(node);
+        node = node->NextSiblingElement(name);
+    }
+
+    return elems;
+}
+
+[[nodiscard]] static constexpr Vector2 vec2_from_lat_lon(float lat, float lon, float width, float height) {
+    float x = ((width/360.0) * (180 + lon));
+    float y = ((height/180.0) * (90 - lat));
+    return { x, y };
+}
+
+struct LatLon {
+    double m_lat;
+    double m_lon;
+};
+
+// great-circle distance
+[[nodiscard]] static double haversine_metres(LatLon a, LatLon b) {
+    constexpr double earth_radius = 6371008.8;
+    constexpr double to_radians = std::numbers::pi / 180.0;
+
+    double dlat = (b.m_lat - a.m_lat) * to_radians;
+    double dlon = (b.m_lon - a.m_lon) * to_radians;
+    double h = std::sin(dlat/2) * std::sin(dlat/2)
+             + std::cos(a.m_lat * to_radians) * std::cos(b.m_lat * to_radians) * std::sin(dlon/2) * std::sin(dlon/2);
+
+    return 2 * earth_radius * std::asin(std::min(1.0, std::sqrt(h)));
+}
+
+// what the edge weights of a loaded map measure
+// weights are stored as fixed-point integers, so the hot loops of the solvers stay integer-only
+enum class Metric {
+    Length,     // centimetres
+    TravelTime, // milliseconds
+};
+
+static constexpr double WEIGHT_PER_METRE = 100;
+static constexpr double WEIGHT_PER_SECOND = 1000;
+
+[[nodiscard]] static Weight to_weight(double value) {
+    return static_cast<Weight>(std::clamp(std::round(value), 0.0, static_cast<double>(std::numeric_limits<Weight>::max())));
+}
+
+// km/h from the maxspeed tag of a way, or a typical speed for its highway class if it has none
+[[nodiscard]] static double speed_kmh_from_tags(std::optional<std::string_view> highway, std::optional<std::string_view> maxspeed) {
+    static constexpr std::pair<std::string_view, double> highway_speeds[] {
+        { "motorway",       120 },
+        { "motorway_link",  60  },
+        { "trunk",          100 },
+        { "trunk_link",     50  },
+        { "primary",        80  },
+        { "primary_link",   50  },
+        { "secondary",      70  },
+        { "secondary_link", 50  },
+        { "tertiary",       60  },
+        { "tertiary_link",  40  },
+        { "unclassified",   50  },
+        { "residential",    30  },
+        { "service",        20  },
+        { "living_street",  10  },
+        { "track",          15  },
+        { "pedestrian",     5   },
+        { "footway",        5   },
+        { "path",           5   },
+        { "steps",          3   },
+    };
+    double default_speed = 30;
+
+    if (maxspeed) {
+        double speed = 0;
+        auto [end, ec] = std::from_chars(maxspeed->data(), maxspeed->data() + maxspeed->size(), speed);
+        // non-numeric values like "none" or "walk" fall back to the highway class
+        if (ec == std::errc { } && speed > 0) {
+            bool mph = std::string_view(end, maxspeed->data() + maxspeed->size()).find("mph") != std::string_view::npos;
+            return mph ? speed * 1.609344 : speed;
+        }
+    }
+
+    if (highway) {
+        auto it = ranges::find(highway_speeds, *highway, &std::pair<std::string_view, double>::first);
+        if (it != std::end(highway_speeds)) {
+            return it->second;
+        }
+    }
+
+    return default_speed;
+}
+
+[[nodiscard]] static double way_speed_kmh(tinyxml2::XMLElement *way) {
+    std::optional<std::string_view> highway;
+    std::optional<std::string_view> maxspeed;
+
+    for (auto &tag : xml_get_child_elements(way, "tag")) {
+        auto key = tag->Attribute("k");
+        auto value = tag->Attribute("v");
+        if (key == nullptr || value == nullptr) continue;
+
+        if (std::string_view(key) == "highway") highway = value;
+        if (std::string_view(key) == "maxspeed") maxspeed = value;
+    }
+
+    return speed_kmh_from_tags(highway, maxspeed);
+}
+
+// progress and statistics of the osm loaders, printed to stderr
+// off by default, switched on at runtime with set_enabled() or the PATHFINDING_PROGRESS environment variable
+// loaders count per block instead of per element, and at most one progress line is printed per m_interval
+class LoadReporter {
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds m_interval { 500 };
+
+    std::atomic<bool> m_enabled = std::getenv("PATHFINDING_PROGRESS") != nullptr;
+    std::atomic<uint64_t> m_nodes = 0;
+    std::atomic<uint64_t> m_ways = 0;
+    std::atomic<uint64_t> m_bytes = 0;
+    std::atomic<Clock::rep> m_next_report = 0;
+
+    // only touched by the thread running the loader
+    Clock::time_point m_start;
+    Clock::time_point m_phase_start;
+    std::string_view m_phase;
+    std::vector<std::pair<std::string_view, double>> m_phase_seconds;
+    size_t m_pruned = 0;
+    size_t m_pruned_bytes = 0;
+
+public:
+    void set_enabled(bool enabled) {
+        m_enabled = enabled;
+    }
+
+    [[nodiscard]] bool is_enabled() const {
+        return m_enabled;
+    }
+
+    void begin(std::string_view phase) {
+        m_nodes = 0;
+        m_ways = 0;
+        m_bytes = 0;
+        m_phase_seconds.clear();
+        m_pruned = 0;
+        m_pruned_bytes = 0;
+        m_start = Clock::now();
+        m_phase_start = m_start;
+        m_phase = phase;
+        m_next_report = (m_start + m_interval).time_since_epoch().count();
+    }
+
+    // phases entered several times, like the decoding and merging of each batch, add up
+    void phase(std::string_view phase) {
+        auto now = Clock::now();
+        end_phase(now);
+        m_phase = phase;
+        m_phase_start = now;
+    }
+
+    // safe to call from several threads
+    void add(uint64_t nodes, uint64_t ways, uint64_t bytes) {
+        m_nodes += nodes;
+        m_ways += ways;
+        m_bytes += bytes;
+        if (!m_enabled) return;
+
+        auto now = Clock::now();
+        auto next = m_next_report.load(std::memory_order_relaxed);
+        if (now.time_since_epoch().count() < next) return;
+        // only the thread that moves the deadline prints
+        auto after = (now + m_interval).time_since_epoch().count();
+        if (!m_next_report.compare_exchange_strong(next, after)) return;
+
+        double seconds = std::chrono::duration<double>(now - m_start).count();
+        std::println(stderr, "[load] {:.1f}s: {} nodes, {} ways, {:.1f} MiB, {:.1f} MiB/s",
+                     seconds, m_nodes.load(), m_ways.load(), mib(m_bytes), mib(m_bytes) / seconds);
+    }
+
+    // vertices dropped before the graph was built, and the graph memory that saves
+    void pruned(size_t vertices, size_t bytes) {
+        m_pruned += vertices;
+        m_pruned_bytes += bytes;
+    }
+
+    [[nodiscard]] size_t pruned_count() const {
+        return m_pruned;
+    }
+
+    [[nodiscard]] size_t pruned_bytes() const {
+        return m_pruned_bytes;
+    }
+
+    void finish(std::string_view filename, const Graph &graph) {
+        auto now = Clock::now();
+        end_phase(now);
+        if (!m_enabled) return;
+
+        double seconds = std::chrono::duration<double>(now - m_start).count();
+        std::println(stderr, "[load] {}: {} nodes, {} ways, {:.1f} MiB in {:.3f}s, {:.1f} MiB/s",
+                     filename, m_nodes.load(), m_ways.load(), mib(m_bytes), seconds, mib(m_bytes) / seconds);
+        std::println(stderr, "[load] graph: {} vertices, {} arcs, {:.1f} MiB", graph.size(), graph.arc_count(), mib(graph.memory_bytes()));
+        if (m_pruned != 0) {
+            std::println(stderr, "[load] dropped {} nodes that are not part of any way, {:.1f} MiB", m_pruned, mib(m_pruned_bytes));
+        }
+        for (auto &[phase, phase_seconds] : m_phase_seconds) {
+            std::println(stderr, "[load]   {:<8} {:.3f}s", phase, phase_seconds);
+        }
+    }
+
+private:
+    [[nodiscard]] static double mib(uint64_t bytes) {
+        return static_cast<double>(bytes) / (1 << 20);
+    }
+
+    void end_phase(Clock::time_point now) {
+        double seconds = std::chrono::duration<double>(now - m_phase_start).count();
+        auto it = ranges::find(m_phase_seconds, m_phase, &std::pair<std::string_view, double>::first);
+        if (it == m_phase_seconds.end()) {
+            m_phase_seconds.push_back({ m_phase, seconds });
+        } else {
+            it->second += seconds;
+        }
+    }
+
+};
+
+[[nodiscard]] static LoadReporter &load_reporter() {
+    static LoadReporter reporter;
+    return reporter;
+}
+
+struct OsmNode {
+    VertexId m_id;
+    LatLon m_coords;
+};
+
+// one segment of a way, added to the graph in both directions
+struct OsmSegment {
+    VertexId m_from;
+    VertexId m_to;
+    Weight m_weight;
+};
+
+// nodes and ways decoded from one part of an osm file, independent of the other parts until it is merged
+struct OsmBlock {
+    std::vector<OsmNode> m_nodes;
+    // refs of all ways back to back, way i is [m_way_offsets[i], m_way_offsets[i+1])
+    std::vector<VertexId> m_way_refs;
+    std::vector<size_t> m_way_offsets { 0 };
+    std::vector<double> m_way_speeds;
+    std::vector<OsmSegment> m_segments;
+
+    void add_way(std::span<const VertexId> refs, double speed_kmh) {
+        m_way_refs.insert(m_way_refs.end(), refs.begin(), refs.end());
+        m_way_offsets.push_back(m_way_refs.size());
+        m_way_speeds.push_back(speed_kmh);
+    }
+
+    [[nodiscard]] size_t way_count() const {
+        return m_way_speeds.size();
+    }
+
+    [[nodiscard]] std::span<const VertexId> way_refs(size_t way) const {
+        return std::span(m_way_refs).subspan(m_way_offsets[way], m_way_offsets[way+1] - m_way_offsets[way]);
+    }
+
+    void clear() {
+        m_nodes.clear();
+        m_way_refs.clear();
+        m_way_offsets.assign(1, 0);
+        m_way_speeds.clear();
+        m_segments.clear();
+    }
+
+};
+
+// blocks decoded in parallel before they are merged, a constant so the result doesn't depend on the thread count
+static constexpr size_t OSM_BATCH_SIZE = 64;
+
+// graph construction shared by the osm loaders, fed with nodes and ways as they are parsed
+class OsmGraphBuilder {
+    Metric m_metric;
+    std::unordered_map<VertexId, Vertex> m_vertices;
+    // kept in double precision for the edge lengths, the float positions are only good for drawing
+    std::unordered_map<VertexId, LatLon> m_coords;
+    std::vector<OsmSegment> m_segments;
+
+public:
+    explicit OsmGraphBuilder(Metric metric) : m_metric(metric) { }
+
+    void add_node(VertexId id, LatLon coords) {
+        m_coords[id] = coords;
+
+        Vector2 pos = vec2_from_lat_lon(coords.m_lat, coords.m_lon, 1.0f, 1.0f);
+        pos.x -= 0.52;
+        pos.y -= 0.22;
+        pos *= 30;
+
+        m_vertices[id] = { id, { }, pos };
+    }
+
+    // ways have to come after the nodes they reference, as in osm files
+    void add_way(std::span<const VertexId> refs, double speed_kmh) {
+        m_segments.clear();
+        way_segments(refs, speed_kmh, m_segments);
+        add_segments(m_segments);
+    }
+
+    // doesn't modify the builder, so it can run on several threads between merges
+    void way_segments(std::span<const VertexId> refs, double speed_kmh, std::vector<OsmSegment> &segments) const {
+        double metres_per_second = speed_kmh / 3.6;
+
+        // a way is a polyline, only consecutive nodes are connected
+        for (size_t i = 1; i < refs.size(); ++i) {
+            VertexId id = refs[i-1];
+            VertexId other_id = refs[i];
+            if (other_id == id) continue;
+
+            // ways can reference nodes that were cut off by the extract
+            auto coords = m_coords.find(id);
+            auto other_coords = m_coords.find(other_id);
+            if (coords == m_coords.end() || other_coords == m_coords.end()) continue;
+
+            double metres = haversine_metres(coords->second, other_coords->second);
+            Weight weight = m_metric == Metric::Length
+                ? to_weight(metres * WEIGHT_PER_METRE)
+                : to_weight(metres / metres_per_second * WEIGHT_PER_SECOND);
+
+            segments.push_back({ id, other_id, weight });
+        }
+    }
+
+    void add_segments(std::span<const OsmSegment> segments) {
+        for (auto &segment : segments) {
+            m_vertices[segment.m_from].m_neighbours.push_back(Edge { segment.m_to, segment.m_weight });
+            m_vertices[segment.m_to].m_neighbours.push_back(Edge { segment.m_from, segment.m_weight });
+        }
+    }
+
+    // nodes that aren't part of any way, like the buildings and other points of interest in an extract, are
+    // dropped: they can't be routed through and would only take up space in the graph and the solvers
+    [[nodiscard]] Graph build() {
+        size_t pruned = std::erase_if(m_vertices, [](auto &entry) { return entry.second.m_neighbours.empty(); });
+        load_reporter().pruned(pruned, Graph::memory_bytes(pruned, 0) - Graph::memory_bytes(0, 0));
+
+        return Graph(m_vertices);
+    }
+
+};
+
+// merges decoded blocks in file order, so the graph doesn't depend on how they were decoded
+// the segment weights of the ways are computed in parallel, once the nodes of all blocks are known
+static void merge_osm_blocks(OsmGraphBuilder &builder, std::span<OsmBlock> blocks, unsigned thread_count) {
+    for (auto &block : blocks) {
+        for (auto &node : block.m_nodes) {
+            builder.add_node(node.m_id, node.m_coords);
+        }
+    }
+
+    parallel_for(blocks.size(), thread_count, [&](size_t i, unsigned) {
+        auto &block = blocks[i];
+        block.m_segments.clear();
+        for (size_t way = 0; way < block.way_count(); ++way) {
+            builder.way_segments(block.way_refs(way), block.m_way_speeds[way], block.m_segments);
+        }
+    });
+
+    for (auto &block : blocks) {
+        builder.add_segments(block.m_segments);
+    }
+}
+
+// end of a null terminated string, so the parsers below can work on tinyxml2 attribute values without a strlen
+struct NullTerminated {
+    friend bool operator==(const char *str, NullTerminated) {
+        return *str == '\0';
+    }
+};
+
+// decimal integer, 0 if there are no digits
+template <std::sentinel_for<const char*> End>
+[[nodiscard]] static VertexId parse_id(const char *str, End end) {
+    bool negative = str != end && *str == '-';
+    if (negative) str++;
+
+    uint64_t value = 0;
+    for (; str != end && *str >= '0' && *str <= '9'; ++str) {
+        value = value * 10 + (*str - '0');
+    }
+    return negative ? -static_cast<VertexId>(value) : static_cast<VertexId>(value);
+}
+
+[[nodiscard]] static VertexId parse_id(std::string_view str) {
+    return parse_id(str.data(), str.data() + str.size());
+}
+
+// osm coordinates have 7 decimals, which fit into an int32 in units of 1e-7 degrees
+static constexpr int COORDINATE_DECIMALS = 7;
+
+// parses a coordinate like "-48.1998537" into units of 1e-7 degrees without going through floating point
+// missing decimals count as zeros, further ones are rounded, nullopt without digits or outside of +-214 degrees
+template <std::sentinel_for<const char*> End>
+[[nodiscard]] static std::optional<int32_t> parse_fixed_coordinate(const char *str, End end) {
+    bool negative = str != end && *str == '-';
+    if (negative || (str != end && *str == '+')) str++;
+
+    int64_t value = 0;
+    bool any_digit = false;
+    for (; str != end && *str >= '0' && *str <= '9'; ++str) {
+        value = value * 10 + (*str - '0');
+        any_digit = true;
+        if (value > std::numeric_limits<int32_t>::max()) return std::nullopt;
+    }
+
+    int decimals = 0;
+    if (str != end && *str == '.') {
+        for (++str; str != end && *str >= '0' && *str <= '9'; ++str) {
+            any_digit = true;
+            if (decimals < COORDINATE_DECIMALS) {
+                value = value * 10 + (*str - '0');
+                decimals++;
+            } else if (decimals == COORDINATE_DECIMALS) {
+                // first dropped digit decides the rounding
+                if (*str >= '5') value++;
+                decimals++;
+            }
+        }
+    }
+    if (!any_digit) return std::nullopt;
+
+    for (; decimals < COORDINATE_DECIMALS; ++decimals) {
+        value *= 10;
+    }
+    if (value > std::numeric_limits<int32_t>::max()) return std::nullopt;
+
+    return static_cast<int32_t>(negative ? -value : value);
+}
+
+[[nodiscard]] static std::optional<int32_t> parse_fixed_coordinate(std::string_view str) {
+    return parse_fixed_coordinate(str.data(), str.data() + str.size());
+}
+
+// divided instead of multiplied by 1e-7, that gives the same double as parsing the decimal
+[[nodiscard]] static LatLon lat_lon_from_fixed(int32_t lat, int32_t lon) {
+    return { lat / 1e7, lon / 1e7 };
+}
+
+// nullopt if the file is missing or isn't osm xml
+[[nodiscard]] static std::optional<Graph> vertices_from_xml(const char *filename, Metric metric = Metric::Length) {
+    auto &reporter = load_reporter();
+    reporter.begin("parse");
+
+    OsmGraphBuilder builder(metric);
+
+    tinyxml2::XMLDocument doc;
+    // parsed in place in a private mapping, no copy of the whole file
+    if (doc.LoadFileMapped(filename) != tinyxml2::XML_SUCCESS) return std::nullopt;
+
+    auto osm = doc.FirstChildElement("osm");
+    if (osm == nullptr) return std::nullopt;
+
+    std::error_code error;
+    auto file_size = std::filesystem::file_size(filename, error);
+    reporter.add(0, 0, error ? 0 : file_size);
+    reporter.phase("nodes");
+
+    auto nodes = xml_get_child_elements(osm, "node");
+
+    static constexpr const char *node_attributes[] { "id", "lat", "lon" };
+    const char *values[std::size(node_attributes)];
+
+    for (auto &node : nodes) {
+        if (node->Attributes(node_attributes, values, std::size(values)) != std::size(values)) continue;
+        auto [id, lat_str, lon_str] = values;
+
+        auto lat = parse_fixed_coordinate(lat_str, NullTerminated { });
+        auto lon = parse_fixed_coordinate(lon_str, NullTerminated { });
+        if (!lat || !lon) continue;
+
+        builder.add_node(parse_id(id, NullTerminated { }), lat_lon_from_fixed(*lat, *lon));
+    }
+    reporter.add(nodes.size(), 0, 0);
+    reporter.phase("ways");
+
+    auto ways = xml_get_child_elements(osm, "way");
+
+    std::vector<VertexId> refs;
+
+    for (auto &way : ways) {
+        double speed = metric == Metric::TravelTime ? way_speed_kmh(way) : 0;
+
+        refs.clear();
+        for (auto &nd : xml_get_child_elements(way, "nd")) {
+            if (auto ref = nd->Attribute("ref")) {
+                refs.push_back(parse_id(ref, NullTerminated { }));
+            }
+        }
+
+        builder.add_way(refs, speed);
+    }
+    reporter.add(0, ways.size(), 0);
+    reporter.phase("build");
+
+    auto graph = builder.build();
+    reporter.finish(filename, graph);
+    return graph;
+}
+
+// streaming xml reader for osm files
+// reads the file in fixed size chunks and reports one tag at a time, so memory doesn't grow with the file size
+// can also read from a buffer in memory, for parts of a file that are parsed in parallel
+// comments, processing instructions, doctypes and text are skipped, entities in attribute values are not decoded
+class OsmXmlReader {
+public:
+    enum class TagKind {
+        Start, // <name>
+        End,   // </name>
+        Empty, // <name/>
+    };
+
+    struct Attribute {
+        std::string_view m_name;
+        std::string_view m_value;
+    };
+
+private:
+    static constexpr size_t m_chunk_size = 1 << 20;
+
+    FILE *m_file = nullptr;
+    std::vector<char> m_buffer;
+    const char *m_data = nullptr; // m_buffer, or the caller's buffer
+    size_t m_pos = 0; // start of the unparsed data in m_data
+    size_t m_end = 0; // end of the valid data in m_data
+    size_t m_bytes_read = 0;
+    bool m_eof = false;
+    bool m_truncated = false; // the data ended inside a tag
+
+    // current tag, the views point into m_data and are valid until the next call to next()
+    TagKind m_kind = TagKind::Start;
+    std::string_view m_name;
+    std::vector<Attribute> m_attributes;
+
+public:
+    explicit OsmXmlReader(const char *filename)
+        : m_file(std::fopen(filename, "rb"))
+        , m_buffer(m_chunk_size)
+        , m_data(m_buffer.data())
+    { }
+
+    // the data has to outlive the reader
+    explicit OsmXmlReader(std::string_view data)
+        : m_data(data.data())
+        , m_end(data.size())
+        , m_bytes_read(data.size())
+        , m_eof(true)
+    { }
+
+    OsmXmlReader(const OsmXmlReader &) = delete;
+    OsmXmlReader &operator=(const OsmXmlReader &) = delete;
+
+    ~OsmXmlReader() {
+        if (m_file != nullptr) std::fclose(m_file);
+    }
+
+    // a buffer reader is always open, a file reader only if the file could be opened
+    [[nodiscard]] bool is_open() const {
+        return m_file != nullptr || m_eof;
+    }
+
+    // after next() returned false: whether it was because the data ended inside a tag
+    [[nodiscard]] bool is_truncated() const {
+        return m_truncated;
+    }
+
+    [[nodiscard]] size_t bytes_read() const {
+        return m_bytes_read;
+    }
+
+    [[nodiscard]] TagKind kind() const {
+        return m_kind;
+    }
+
+    [[nodiscard]] std::string_view name() const {
+        return m_name;
+    }
+
+    [[nodiscard]] std::span<const Attribute> attributes() const {
+        return m_attributes;
+    }
+
+    [[nodiscard]] std::optional<std::string_view> attribute(std::string_view name) const {
+        auto it = ranges::find(m_attributes, name, &Attribute::m_name);
+        if (it == m_attributes.end()) return std::nullopt;
+        return it->m_value;
+    }
+
+    // advances to the next element tag, returns false at the end of the file or on a truncated tag
+    [[nodiscard]] bool next() {
+        if (!is_open()) return false;
+
+        while (true) {
+            std::string_view data(m_data + m_pos, m_end - m_pos);
+
+            auto open = data.find('<');
+            if (open == std::string_view::npos) {
+                m_pos = m_end;
+                if (!refill()) return false;
+                continue;
+            }
+
+            auto close = find_tag_end(data.substr(open));
+            if (close == std::string_view::npos) {
+                // the tag continues in the next chunk
+                m_pos += open;
+                if (!refill()) {
+                    m_truncated = true;
+                    return false;
+                }
+                continue;
+            }
+
+            auto tag = data.substr(open, close + 1);
+            m_pos += open + close + 1;
+
+            if (tag.starts_with("<?") || tag.starts_with("<!")) continue;
+
+            parse_tag(tag);
+            return true;
+        }
+    }
+
+private:
+    // moves the unparsed rest to the front of the buffer and reads the next chunk after it
+    [[nodiscard]] bool refill() {
+        if (m_eof || m_file == nullptr) return false;
+
+        std::memmove(m_buffer.data(), m_buffer.data() + m_pos, m_end - m_pos);
+        m_end -= m_pos;
+        m_pos = 0;
+
+        // a single tag bigger than the buffer
+        if (m_end == m_buffer.size()) {
+            m_buffer.resize(m_buffer.size() * 2);
+        }
+
+        m_data = m_buffer.data();
+
+        size_t read = std::fread(m_buffer.data() + m_end, 1, m_buffer.size() - m_end, m_file);
+        m_end += read;
+        m_bytes_read += read;
+        if (read == 0) m_eof = true;
+
+        return read > 0;
+    }
+
+    // index of the '>' that closes the tag starting at data[0], npos if it is not in data
+    [[nodiscard]] static size_t find_tag_end(std::string_view data) {
+        if (data.starts_with("<!--")) {
+            auto end = data.find("-->");
+            return end == std::string_view::npos ? end : end + 2;
+        }
+        if (data.starts_with("<![CDATA[")) {
+            auto end = data.find("]]>");
+            return end == std::string_view::npos ? end : end + 2;
+        }
+
+        // '>' is allowed inside attribute values
+        char quote = 0;
+        for (size_t i = 1; i < data.size(); ++i) {
+            char c = data[i];
+            if (quote != 0) {
+                if (c == quote) quote = 0;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                return i;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    void parse_tag(std::string_view tag) {
+        // strip '<' and '>'
+        tag = tag.substr(1, tag.size() - 2);
+
+        m_kind = TagKind::Start;
+        if (tag.starts_with('/')) {
+            m_kind = TagKind::End;
+            tag.remove_prefix(1);
+        } else if (tag.ends_with('/')) {
+            m_kind = TagKind::Empty;
+            tag.remove_suffix(1);
+        }
+
+        auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+
+        size_t i = 0;
+        while (i < tag.size() && !is_space(tag[i])) i++;
+        m_name = tag.substr(0, i);
+
+        m_attributes.clear();
+        while (true) {
+            while (i < tag.size() && is_space(tag[i])) i++;
+            if (i >= tag.size()) break;
+
+            size_t name_start = i;
+            while (i < tag.size() && tag[i] != '=' && !is_space(tag[i])) i++;
+            auto name = tag.substr(name_start, i - name_start);
+
+            while (i < tag.size() && (is_space(tag[i]) || tag[i] == '=')) i++;
+            if (i >= tag.size()) break;
+
+            char quote = tag[i];
+            auto value_end = tag.find(quote, i + 1);
+            if (value_end == std::string_view::npos) break;
+
+            m_attributes.push_back({ name, tag.substr(i + 1, value_end - i - 1) });
+            i = value_end + 1;
+        }
+    }
+
+};
+
+// collects the nodes and ways from the tags reported by an OsmXmlReader
+class OsmXmlElementParser {
+    Metric m_metric;
+    bool m_in_way = false;
+    bool m_found_root = false;
+    std::vector<VertexId> m_refs;
+    // copied, the reader's views don't survive until the end of the way
+    std::optional<std::string> m_highway;
+    std::optional<std::string> m_maxspeed;
+
+public:
+    explicit OsmXmlElementParser(Metric metric) : m_metric(metric) { }
+
+    // the parser is between elements, everything read so far is in the block
+    [[nodiscard]] bool in_way() const {
+        return m_in_way;
+    }
+
+    // an <osm> root tag was read, the data is osm xml at all
+    [[nodiscard]] bool found_root() const {
+        return m_found_root;
+    }
+
+    void handle(const OsmXmlReader &reader, OsmBlock &block) {
+        auto name = reader.name();
+        auto kind = reader.kind();
+
+        if (name == "osm" && kind != OsmXmlReader::TagKind::End) {
+            m_found_root = true;
+
+        } else if (name == "node" && kind != OsmXmlReader::TagKind::End) {
+            auto id = reader.attribute("id");
+            auto lat_str = reader.attribute("lat");
+            auto lon_str = reader.attribute("lon");
+            if (!id || !lat_str || !lon_str) return;
+
+            auto lat = parse_fixed_coordinate(*lat_str);
+            auto lon = parse_fixed_coordinate(*lon_str);
+            if (!lat || !lon) return;
+
+            block.m_nodes.push_back({ parse_id(*id), lat_lon_from_fixed(*lat, *lon) });
+
+        } else if (name == "way") {
+            if (kind == OsmXmlReader::TagKind::Start) {
+                m_in_way = true;
+                m_refs.clear();
+                m_highway.reset();
+                m_maxspeed.reset();
+            } else if (kind == OsmXmlReader::TagKind::End) {
+                m_in_way = false;
+                double speed = m_metric == Metric::TravelTime ? speed_kmh_from_tags(m_highway, m_maxspeed) : 0;
+                block.add_way(m_refs, speed);
+            }
+
+        } else if (m_in_way && name == "nd") {
+            if (auto ref = reader.attribute("ref")) {
+                m_refs.push_back(parse_id(*ref));
+            }
+
+        } else if (m_in_way && name == "tag") {
+            auto key = reader.attribute("k");
+            auto value = reader.attribute("v");
+            if (!key || !value) return;
+
+            if (*key == "highway") m_highway = *value;
+            if (*key == "maxspeed") m_maxspeed = *value;
+        }
+    }
+
+};
+
+// same result as vertices_from_xml, but the file is streamed instead of loaded into a dom
+// memory use is bounded by the size of the graph, not the size of the xml
+// nullopt if the file is missing, isn't osm xml or ends inside a tag
+[[nodiscard]] static std::optional<Graph> vertices_from_osm_stream(const char *filename, Metric metric = Metric::Length) {
+    // elements collected before they are added to the graph
+    size_t flush_size = 1 << 16;
+
+    auto &reporter = load_reporter();
+    reporter.begin("parse");
+
+    OsmGraphBuilder builder(metric);
+    OsmXmlElementParser parser(metric);
+    OsmBlock block;
+    size_t bytes_reported = 0;
+
+    OsmXmlReader reader(filename);
+    if (!reader.is_open()) return std::nullopt;
+
+    auto flush = [&] {
+        merge_osm_blocks(builder, std::span(&block, 1), 1);
+        reporter.add(block.m_nodes.size(), block.way_count(), reader.bytes_read() - bytes_reported);
+        bytes_reported = reader.bytes_read();
+        block.clear();
+    };
+
+    while (reader.next()) {
+        parser.handle(reader, block);
+
+        if (!parser.in_way() && block.m_nodes.size() + block.way_count() >= flush_size) {
+            flush();
+        }
+    }
+    if (reader.is_truncated() || !parser.found_root()) return std::nullopt;
+    flush();
+    reporter.phase("build");
+
+    auto graph = builder.build();
+    reporter.finish(filename, graph);
+    return graph;
+}
+
+// splits osm xml into parts of about chunk_size bytes, each one starting at a <node> or <way> tag
+// those are never nested in each other, so every part can be parsed on its own
+[[nodiscard]] static std::vector<std::string_view> split_osm_xml(std::string_view xml, size_t chunk_size) {
+    auto find_element = [&](size_t from) {
+        for (size_t pos = from; (pos = xml.find('<', pos)) != std::string_view::npos; ++pos) {
+            auto tag = xml.substr(pos + 1);
+            for (std::string_view name : { "node", "way" }) {
+                if (tag.starts_with(name) && tag.size() > name.size()) {
+                    char next = tag[name.size()];
+                    if (next == ' ' || next == '\t' || next == '\n' || next == '\r' || next == '>' || next == '/') return pos;
+                }
+            }
+        }
+        return xml.size();
+    };
+
+    std::vector<std::string_view> chunks;
+    size_t start = 0;
+    while (start < xml.size()) {
+        size_t end = xml.size();
+        if (xml.size() - start > chunk_size) {
+            end = find_element(start + chunk_size);
+        }
+        chunks.push_back(xml.substr(start, end - start));
+        start = end;
+    }
+    return chunks;
+}
+
+// parses parts of the mapped xml on thread_count threads, the graph is the same for any thread count
+// nullopt if the file is missing, isn't osm xml or ends inside a tag
+[[nodiscard]] static std::optional<Graph> vertices_from_xml_parallel(const char *filename, Metric metric = Metric::Length,
+                                                     unsigned thread_count = default_thread_count()) {
+    size_t chunk_size = 4 << 20;
+
+    auto &reporter = load_reporter();
+    reporter.begin("split");
+
+    MappedFile file(filename);
+    if (!file.is_open()) return std::nullopt;
+
+    auto data = file.data();
+    auto chunks = split_osm_xml({ data.data(), data.size() }, chunk_size);
+
+    OsmGraphBuilder builder(metric);
+    std::vector<OsmBlock> blocks(OSM_BATCH_SIZE);
+    std::atomic<bool> found_root = false;
+    std::atomic<bool> truncated = false;
+
+    for (size_t first = 0; first < chunks.size(); first += OSM_BATCH_SIZE) {
+        size_t count = std::min(OSM_BATCH_SIZE, chunks.size() - first);
+
+        reporter.phase("decode");
+        parallel_for(count, thread_count, [&](size_t i, unsigned) {
+            auto &block = blocks[i];
+            block.clear();
+
+            OsmXmlReader reader(chunks[first + i]);
+            OsmXmlElementParser parser(metric);
+            while (reader.next()) {
+                parser.handle(reader, block);
+            }
+            if (parser.found_root()) found_root = true;
+            if (reader.is_truncated()) truncated = true;
+            reporter.add(block.m_nodes.size(), block.way_count(), chunks[first + i].size());
+        });
+        if (truncated) return std::nullopt;
+
+        reporter.phase("merge");
+        merge_osm_blocks(builder, std::span(blocks).first(count), thread_count);
+    }
+    if (!found_root) return std::nullopt;
+    reporter.phase("build");
+
+    auto graph = builder.build();
+    reporter.finish(filename, graph);
+    return graph;
+}
+
+// inflate (rfc 1951) with the zlib wrapper (rfc 1950), enough for the compressed blobs in osm pbf files
+class Inflater {
+    // canonical huffman code, codes up to m_fast_bits long are decoded with a single table lookup
+    struct Huffman {
+        static constexpr int m_max_bits = 15;
+        static constexpr int m_fast_bits = 9;
+        std::array<uint16_t, m_max_bits + 1> m_counts { };
+        std::array<uint16_t, 288> m_symbols { };
+        // symbol << 4 | code length, 0 for codes longer than m_fast_bits
+        std::array<uint16_t, 1 << m_fast_bits> m_fast { };
+    };
+
+    std::span<const uint8_t> m_in;
+    std::vector<uint8_t> &m_out;
+    // size of out before this stream, the bytes before it are neither counted nor referenced
+    size_t m_start;
+    size_t m_max_size;
+    size_t m_pos = 0;
+    uint64_t m_bit_buffer = 0;
+    int m_bit_count = 0;
+
+    Inflater(std::span<const uint8_t> in, std::vector<uint8_t> &out, size_t max_size)
+        : m_in(in)
+        , m_out(out)
+        , m_start(out.size())
+        , m_max_size(max_size)
+    { }
+
+    // bytes of this stream written to m_out so far
+    [[nodiscard]] size_t produced() const {
+        return m_out.size() - m_start;
+    }
+
+public:
+    // decompresses a zlib stream, appending at most max_size bytes to out
+    [[nodiscard]] static bool zlib_decompress(std::span<const uint8_t> in, std::vector<uint8_t> &out, size_t max_size) {
+        if (in.size() < 6) return false;
+
+        // deflate, no preset dictionary
+        uint8_t cmf = in[0];
+        uint8_t flg = in[1];
+        if ((cmf & 0x0f) != 8 || (cmf << 8 | flg) % 31 != 0 || (flg & 0x20) != 0) return false;
+
+        size_t start = out.size();
+        Inflater inflater(in.subspan(2), out, max_size);
+        if (!inflater.inflate()) return false;
+
+        inflater.align_to_byte();
+        uint32_t expected = 0;
+        for (int i = 0; i < 4; ++i) {
+            expected = expected << 8 | inflater.bits(8);
+        }
+        if (inflater.overrun()) return false;
+
+        return adler32(std::span(out).subspan(start)) == expected;
+    }
+
+private:
+    [[nodiscard]] static uint32_t adler32(std::span<const uint8_t> data) {
+        uint32_t a = 1;
+        uint32_t b = 0;
+        // largest block that can't overflow b before the modulo
+        size_t block = 5552;
+        for (size_t i = 0; i < data.size(); i += block) {
+            for (auto byte : data.subspan(i, std::min(block, data.size() - i))) {
+                a += byte;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return b << 16 | a;
+    }
+
+    void refill() {
+        while (m_bit_count <= 56) {
+            // reading past the end yields zeros, overrun() tells if they were consumed
+            uint64_t byte = m_pos < m_in.size() ? m_in[m_pos] : 0;
+            m_pos++;
+            m_bit_buffer |= byte << m_bit_count;
+            m_bit_count += 8;
+        }
+    }
+
+    [[nodiscard]] bool overrun() const {
+        return m_pos - m_bit_count / 8 > m_in.size();
+    }
+
+    [[nodiscard]] uint32_t bits(int count) {
+        if (m_bit_count < count) refill();
+        uint32_t value = m_bit_buffer & ((uint64_t { 1 } << count) - 1);
+        m_bit_buffer >>= count;
+        m_bit_count -= count;
+        return value;
+    }
+
+    void align_to_byte() {
+        m_bit_buffer >>= m_bit_count % 8;
+        m_bit_count -= m_bit_count % 8;
+    }
+
+    // incomplete codes are allowed, deflate uses them for a single distance code
+    [[nodiscard]] static bool build(Huffman &huffman, std::span<const uint8_t> lengths) {
+        huffman.m_counts.fill(0);
+        huffman.m_fast.fill(0);
+        for (auto length : lengths) {
+            huffman.m_counts[length]++;
+        }
+        huffman.m_counts[0] = 0;
+
+        int left = 1;
+        for (int len = 1; len <= Huffman::m_max_bits; ++len) {
+            left <<= 1;
+            left -= huffman.m_counts[len];
+            if (left < 0) return false;
+        }
+
+        std::array<uint16_t, Huffman::m_max_bits + 1> offsets { };
+        std::array<uint32_t, Huffman::m_max_bits + 1> next_code { };
+        for (int len = 1; len < Huffman::m_max_bits; ++len) {
+            offsets[len + 1] = offsets[len] + huffman.m_counts[len];
+        }
+        for (int len = 2; len <= Huffman::m_max_bits; ++len) {
+            next_code[len] = (next_code[len - 1] + huffman.m_counts[len - 1]) << 1;
+        }
+
+        for (size_t symbol = 0; symbol < lengths.size(); ++symbol) {
+            int len = lengths[symbol];
+            if (len == 0) continue;
+            huffman.m_symbols[offsets[len]++] = symbol;
+
+            uint32_t code = next_code[len]++;
+            if (len > Huffman::m_fast_bits) continue;
+
+            // codes are packed starting with their most significant bit
+            uint32_t reversed = 0;
+            for (int i = 0; i < len; ++i) {
+                reversed |= (code >> i & 1) << (len - 1 - i);
+            }
+            for (uint32_t i = reversed; i < huffman.m_fast.size(); i += 1 << len) {
+                huffman.m_fast[i] = symbol << 4 | len;
+            }
+        }
+
+        return true;
+    }
+
+    // -1 on an invalid code
+    [[nodiscard]] int decode(const Huffman &huffman) {
+        if (m_bit_count < Huffman::m_max_bits) refill();
+
+        uint16_t entry = huffman.m_fast[m_bit_buffer & (huffman.m_fast.size() - 1)];
+        if (entry != 0) {
+            int len = entry & 0x0f;
+            m_bit_buffer >>= len;
+            m_bit_count -= len;
+            return entry >> 4;
+        }
+
+        // walk the canonical code one bit at a time
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int len = 1; len <= Huffman::m_max_bits; ++len) {
+            code |= m_bit_buffer >> (len - 1) & 1;
+            int count = huffman.m_counts[len];
+            if (code - first < count) {
+                m_bit_buffer >>= len;
+                m_bit_count -= len;
+                return huffman.m_symbols[index + code - first];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    [[nodiscard]] bool inflate() {
+        bool last = false;
+        while (!last) {
+            last = bits(1);
+            uint32_t type = bits(2);
+
+            bool ok = false;
+            if (type == 0) {
+                ok = stored_block();
+            } else if (type == 1) {
+                ok = fixed_block();
+            } else if (type == 2) {
+                ok = dynamic_block();
+            }
+            if (!ok || overrun()) return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool stored_block() {
+        align_to_byte();
+        uint32_t length = bits(16);
+        uint32_t complement = bits(16);
+        if ((length ^ 0xffff) != complement) return false;
+        if (produced() + length > m_max_size) return false;
+
+        for (uint32_t i = 0; i < length; ++i) {
+            m_out.push_back(bits(8));
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool fixed_block() {
+        static const auto codes = [] {
+            std::array<uint8_t, 288 + 30> lengths;
+            std::fill(lengths.begin(), lengths.begin() + 144, 8);
+            std::fill(lengths.begin() + 144, lengths.begin() + 256, 9);
+            std::fill(lengths.begin() + 256, lengths.begin() + 280, 7);
+            std::fill(lengths.begin() + 280, lengths.begin() + 288, 8);
+            std::fill(lengths.begin() + 288, lengths.end(), 5);
+
+            std::pair<Huffman, Huffman> codes;
+            bool ok = build(codes.first, std::span(lengths).first(288))
+                && build(codes.second, std::span(lengths).subspan(288));
+            assert(ok);
+            return codes;
+        }();
+
+        return codes_block(codes.first, codes.second);
+    }
+
+    [[nodiscard]] bool dynamic_block() {
+        static constexpr uint8_t order[19] { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        uint32_t literal_count = bits(5) + 257;
+        uint32_t distance_count = bits(5) + 1;
+        uint32_t length_code_count = bits(4) + 4;
+        if (literal_count > 286 || distance_count > 30) return false;
+
+        std::array<uint8_t, 19> length_lengths { };
+        for (uint32_t i = 0; i < length_code_count; ++i) {
+            length_lengths[order[i]] = bits(3);
+        }
+
+        Huffman length_code;
+        if (!build(length_code, length_lengths)) return false;
+
+        std::array<uint8_t, 286 + 30> lengths { };
+        uint32_t count = literal_count + distance_count;
+        for (uint32_t i = 0; i < count; ) {
+            int symbol = decode(length_code);
+            if (symbol < 0) return false;
+
+            if (symbol < 16) {
+                lengths[i++] = symbol;
+                continue;
+            }
+
+            uint8_t value = 0;
+            uint32_t repeat = 0;
+            if (symbol == 16) {
+                if (i == 0) return false;
+                value = lengths[i - 1];
+                repeat = 3 + bits(2);
+            } else if (symbol == 17) {
+                repeat = 3 + bits(3);
+            } else {
+                repeat = 11 + bits(7);
+            }
+            if (i + repeat > count) return false;
+            std::fill_n(lengths.begin() + i, repeat, value);
+            i += repeat;
+        }
+
+        // a block without an end code can't be terminated
+        if (lengths[256] == 0) return false;
+
+        Huffman literal_code;
+        Huffman distance_code;
+        return build(literal_code, std::span(lengths).first(literal_count))
+            && build(distance_code, std::span(lengths).subspan(literal_count, distance_count))
+            && codes_block(literal_code, distance_code);
+    }
+
+    [[nodiscard]] bool codes_block(const Huffman &literal_code, const Huffman &distance_code) {
+        static constexpr uint16_t length_base[29] {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+        };
+        static constexpr uint8_t length_extra[29] {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+        };
+        static constexpr uint16_t distance_base[30] {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+        };
+        static constexpr uint8_t distance_extra[30] {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+        };
+
+        while (true) {
+            int symbol = decode(literal_code);
+            if (symbol < 0) return false;
+
+            if (symbol < 256) {
+                if (produced() >= m_max_size) return false;
+                m_out.push_back(symbol);
+                continue;
+            }
+            if (symbol == 256) return true;
+
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            size_t length = length_base[symbol] + bits(length_extra[symbol]);
+
+            int distance_symbol = decode(distance_code);
+            if (distance_symbol < 0 || distance_symbol >= 30) return false;
+            size_t distance = distance_base[distance_symbol] + bits(distance_extra[distance_symbol]);
+
+            if (distance > produced() || produced() + length > m_max_size) return false;
+            if (overrun()) return false;
+
+            // the copy can overlap the bytes it produces
+            size_t from = m_out.size() - distance;
+            for (size_t i = 0; i < length; ++i) {
+                m_out.push_back(m_out[from + i]);
+            }
+        }
+    }
+
+};
+
+[[nodiscard]] static int64_t zigzag_decode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// protobuf wire format reader, visits the fields of one message in order
+// any malformed input makes next() return false and ok() report it
+class ProtoReader {
+    const uint8_t *m_pos;
+    const uint8_t *m_end;
+    bool m_ok = true;
+    uint32_t m_field = 0;
+    uint32_t m_wire_type = 0;
 
-        VertexId prev = dest;
-        while (prev != m_source) {
-            prev = m_table.at(prev).m_prev;
-            path.push_back(prev);
-        }
+public:
+    enum WireType : uint32_t {
+        Varint = 0,
+        Fixed64 = 1,
+        LengthDelimited = 2,
+        Fixed32 = 5,
+    };
 
-        ranges::reverse(path);
+    explicit ProtoReader(std::span<const uint8_t> data)
+        : m_pos(data.data())
+        , m_end(data.data() + data.size())
+    { }
 
-        return path;
+    [[nodiscard]] bool ok() const {
+        return m_ok;
     }
 
-    [[nodiscard]] bool is_done() const {
-        return m_state == State::Terminated;
+    [[nodiscard]] bool at_end() const {
+        return m_pos == m_end;
     }
 
-    void reset() {
-        m_state = State::Idle;
-        ranges::for_each(m_vertices, [&](const std::pair<VertexId, Vertex> &kv) {
-            auto &[key, value] = kv;
-            m_unvisited.push_back(key);
-            m_table[key] = { key == m_source ? 0 : m_inf, -1 };
-        });
+    [[nodiscard]] uint32_t field() const {
+        return m_field;
     }
 
-    void next() {
-        switch (m_state) {
-            case State::Terminated:
-                ;
-                break;
-
-            case State::Idle: {
-
-                if (m_unvisited.empty()) {
-                    m_state = State::Terminated;
-                    assert(m_unvisited.empty());
-                    return;
-                };
+    // reads the key of the next field, its value has to be consumed with one of the readers below
+    [[nodiscard]] bool next() {
+        if (!m_ok || at_end()) return false;
+        uint64_t key = varint();
+        m_field = key >> 3;
+        m_wire_type = key & 7;
+        return m_ok;
+    }
 
-                next_unvisited();
-                m_state = State::NextVertex;
+    [[nodiscard]] uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (m_pos == m_end) break;
+            uint8_t byte = *m_pos++;
+            value |= uint64_t { byte & 0x7fu } << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        m_ok = false;
+        return 0;
+    }
 
-            } break;
+    // zigzag encoded sint32/sint64
+    [[nodiscard]] int64_t svarint() {
+        return zigzag_decode(varint());
+    }
 
-            case State::NextVertex: {
-                auto &vtx = m_vertices.at(m_current);
-                m_neighbour = vtx.m_neighbours.cbegin();
+    [[nodiscard]] std::span<const uint8_t> bytes() {
+        if (m_wire_type != LengthDelimited) {
+            m_ok = false;
+            return { };
+        }
+        uint64_t size = varint();
+        if (!m_ok || size > static_cast<uint64_t>(m_end - m_pos)) {
+            m_ok = false;
+            return { };
+        }
+        std::span<const uint8_t> data(m_pos, size);
+        m_pos += size;
+        return data;
+    }
 
-                bool no_neighbours = m_neighbour == vtx.m_neighbours.end();
+    [[nodiscard]] std::string_view string() {
+        auto data = bytes();
+        return { reinterpret_cast<const char*>(data.data()), data.size() };
+    }
 
-                if (no_neighbours) {
-                    m_unvisited.remove(m_current);
-                    m_state = State::Idle;
-                    return;
-                }
+    void skip() {
+        size_t size = 0;
+        switch (m_wire_type) {
+            case Varint:
+                (void) varint();
+                return;
+            case LengthDelimited:
+                (void) bytes();
+                return;
+            case Fixed64:
+                size = 8;
+                break;
+            case Fixed32:
+                size = 4;
+                break;
+            default:
+                m_ok = false;
+                return;
+        }
+        if (size > static_cast<size_t>(m_end - m_pos)) {
+            m_ok = false;
+            return;
+        }
+        m_pos += size;
+    }
 
-                m_state = State::Visiting;
+};
 
-            } break;
+// decodes a packed repeated varint field, fn is called with each raw value
+template <typename Fn>
+[[nodiscard]] static bool for_each_packed_varint(std::span<const uint8_t> data, Fn fn) {
+    ProtoReader reader(data);
+    while (reader.ok() && !reader.at_end()) {
+        uint64_t value = reader.varint();
+        if (reader.ok()) fn(value);
+    }
+    return reader.ok();
+}
 
-            case State::Visiting: {
-                auto &vtx = m_vertices.at(m_current);
+// reads the blob framing of an osm pbf file, the blobs are decoded separately by OsmPbfDecoder
+class OsmPbfReader {
+    // limits from the format spec
+    static constexpr size_t m_max_header_size = 64 * 1024;
+    static constexpr size_t m_max_blob_size = 32 * 1024 * 1024;
 
-                visit_neighbour();
-                m_neighbour++;
+    FILE *m_file = nullptr;
+    std::vector<uint8_t> m_header;
+    bool m_ok = true;
 
-                if (m_neighbour == vtx.m_neighbours.end()) {
-                    m_unvisited.remove(m_current);
-                    m_state = State::Idle;
-                    return;
-                }
+public:
+    explicit OsmPbfReader(const char *filename) : m_file(std::fopen(filename, "rb")) { }
 
-            } break;
+    OsmPbfReader(const OsmPbfReader &) = delete;
+    OsmPbfReader &operator=(const OsmPbfReader &) = delete;
 
-        }
+    ~OsmPbfReader() {
+        if (m_file != nullptr) std::fclose(m_file);
     }
 
-private:
-    inline void next_unvisited() {
-        m_current = *ranges::min_element(m_unvisited, [&](VertexId a, VertexId b) {
-            int dist_a = m_table.at(a).m_dist;
-            int dist_b = m_table.at(b).m_dist;
-            return dist_a < dist_b;
-        });
+    [[nodiscard]] bool is_open() const {
+        return m_file != nullptr;
     }
 
-    void visit_neighbour() {
-        auto current = m_vertices.at(m_current);
-        int current_dist = m_table.at(current.m_id).m_dist;
-
-        auto v = *m_neighbour;
-        auto other = v.m_other_id;
-
-        bool is_unvisited = ranges::find(m_unvisited, other) != m_unvisited.end();
-        if (!is_unvisited) return;
+    // false once the framing was malformed, not just at the end of the file
+    [[nodiscard]] bool ok() const {
+        return m_ok;
+    }
 
-        int dist = current_dist + v.m_weight;
-        int other_dist = m_table.at(other).m_dist;
-        if (dist < other_dist) {
-            m_table[other] = { dist, current.m_id };
+    // reads the next blob and its type, false at the end of the file or on an error
+    [[nodiscard]] bool next_blob(std::string &type, std::vector<uint8_t> &blob) {
+        if (m_file == nullptr || !m_ok) return false;
+
+        uint8_t size_be[4];
+        size_t read = std::fread(size_be, 1, sizeof size_be, m_file);
+        if (read == 0 && std::feof(m_file)) return false;
+        if (read != sizeof size_be) return fail();
+
+        uint32_t header_size = uint32_t { size_be[0] } << 24 | size_be[1] << 16 | size_be[2] << 8 | size_be[3];
+        if (header_size > m_max_header_size) return fail();
+
+        m_header.resize(header_size);
+        if (std::fread(m_header.data(), 1, header_size, m_file) != header_size) return fail();
+
+        // BlobHeader
+        uint64_t blob_size = 0;
+        type.clear();
+        ProtoReader header(m_header);
+        while (header.next()) {
+            if (header.field() == 1) {
+                type = header.string();
+            } else if (header.field() == 3) {
+                blob_size = header.varint();
+            } else {
+                header.skip();
+            }
         }
+        if (!header.ok() || blob_size > m_max_blob_size) return fail();
+
+        blob.resize(blob_size);
+        if (std::fread(blob.data(), 1, blob_size, m_file) != blob_size) return fail();
 
+        return true;
     }
 
-    [[nodiscard]] static constexpr const char *stringify_state(State state) {
-        switch (state) {
-            case State::Idle:       return "Idle";
-            case State::NextVertex: return "NextVertex";
-            case State::Visiting:   return "Visiting";
-            case State::Terminated: return "Terminated";
-        }
-        std::unreachable();
+private:
+    [[nodiscard]] bool fail() {
+        m_ok = false;
+        return false;
     }
 
 };
 
-class Renderer {
-    const Solver &m_solver;
-    static constexpr float m_fontsize = 50;
-    static constexpr Vector2 m_draw_offset { 0, 0 };
+// decodes pbf blobs into OsmBlocks, one decoder per thread as it keeps its buffers between blobs
+// supports raw and zlib compressed blobs, plain and dense nodes
+class OsmPbfDecoder {
+    static constexpr size_t m_max_blob_size = 32 * 1024 * 1024;
+
+    Metric m_metric;
+    std::vector<uint8_t> m_data;
+
+    // per block state, reused to avoid allocations
+    std::vector<std::string_view> m_strings;
+    std::vector<std::span<const uint8_t>> m_groups;
+    std::vector<uint64_t> m_ids;
+    std::vector<uint64_t> m_lats;
+    std::vector<uint64_t> m_lons;
+    std::vector<uint64_t> m_keys;
+    std::vector<uint64_t> m_values;
+    std::vector<VertexId> m_refs;
 
 public:
-    Renderer(const Solver &solver) : m_solver(solver) { }
+    explicit OsmPbfDecoder(Metric metric) : m_metric(metric) { }
 
-    void draw() const {
+    // appends the nodes and ways of the blob to block
+    // false if the blob is malformed or uses features that aren't supported
+    [[nodiscard]] bool decode(std::string_view type, std::span<const uint8_t> blob, OsmBlock &block) {
+        if (!decode_blob(blob)) return false;
 
-        for (auto &[id, vtx] : m_solver.m_vertices) {
-            auto pos = convert_vertex_pos(vtx.m_pos);
-            draw_neighbours(pos, vtx.m_neighbours);
-        }
+        if (type == "OSMHeader") return check_header();
+        if (type == "OSMData") return read_block(block);
 
-        if (m_solver.m_state == Solver::State::Visiting) {
-            auto other_pos = m_solver.m_vertices.at(m_solver.m_neighbour->m_other_id).m_pos;
-            auto pos = m_solver.m_vertices.at(m_solver.m_current).m_pos;
-            DrawLineEx(convert_vertex_pos(pos), convert_vertex_pos(other_pos), 5, GREEN);
+        // other blob types are to be skipped according to the spec
+        return true;
+    }
+
+private:
+    // decompresses the blob into m_data
+    [[nodiscard]] bool decode_blob(std::span<const uint8_t> data) {
+        std::span<const uint8_t> raw;
+        std::span<const uint8_t> zlib_data;
+        uint64_t raw_size = 0;
+        bool unsupported = false;
+
+        ProtoReader blob(data);
+        while (blob.next()) {
+            switch (blob.field()) {
+                case 1: raw = blob.bytes(); break;
+                case 2: raw_size = blob.varint(); break;
+                case 3: zlib_data = blob.bytes(); break;
+                // lzma, bzip2, lz4, zstd
+                case 4: case 5: case 6: case 7: unsupported = true; blob.skip(); break;
+                default: blob.skip(); break;
+            }
         }
+        if (!blob.ok() || raw_size > m_max_blob_size) return false;
 
-        for (auto &[id, vtx] : m_solver.m_vertices) {
-            draw_vertex(id, vtx);
+        m_data.clear();
+        if (!raw.empty()) {
+            m_data.assign(raw.begin(), raw.end());
+            return true;
+        }
+        if (!zlib_data.empty()) {
+            m_data.reserve(raw_size);
+            return Inflater::zlib_decompress(zlib_data, m_data, raw_size) && m_data.size() == raw_size;
         }
+        return !unsupported;
+    }
 
-        float radius = 10;
-        DrawCircleV(convert_vertex_pos(m_solver.m_vertices.at(m_solver.m_source).m_pos), radius, RED);
+    [[nodiscard]] bool check_header() {
+        ProtoReader header(m_data);
+        while (header.next()) {
+            // required_features
+            if (header.field() == 4) {
+                auto feature = header.string();
+                if (feature != "OsmSchema-V0.6" && feature != "DenseNodes") {
+                    std::println(stderr, "unsupported pbf feature: {}", feature);
+                    return false;
+                }
+            } else {
+                header.skip();
+            }
+        }
+        return header.ok();
+    }
 
-        draw_ui();
+    [[nodiscard]] bool read_block(OsmBlock &block) {
+        // PrimitiveBlock, the groups are decoded after the fields they depend on have been read
+        int64_t granularity = 100;
+        int64_t lat_offset = 0;
+        int64_t lon_offset = 0;
+        m_strings.clear();
+        m_groups.clear();
+
+        ProtoReader primitives(m_data);
+        while (primitives.next()) {
+            switch (primitives.field()) {
+                case 1: {
+                    ProtoReader table(primitives.bytes());
+                    while (table.next()) {
+                        if (table.field() == 1) {
+                            m_strings.push_back(table.string());
+                        } else {
+                            table.skip();
+                        }
+                    }
+                    if (!table.ok()) return false;
+                } break;
+                case 2: m_groups.push_back(primitives.bytes()); break;
+                case 17: granularity = primitives.varint(); break;
+                case 19: lat_offset = primitives.varint(); break;
+                case 20: lon_offset = primitives.varint(); break;
+                default: primitives.skip(); break;
+            }
+        }
+        if (!primitives.ok()) return false;
+
+        // divided instead of multiplied by 1e-9, that is correctly rounded like parsing the decimal in an xml file
+        auto to_coords = [&](int64_t lat, int64_t lon) {
+            return LatLon {
+                static_cast<double>(lat_offset + granularity * lat) / 1e9,
+                static_cast<double>(lon_offset + granularity * lon) / 1e9,
+            };
+        };
+
+        for (auto group_data : m_groups) {
+            ProtoReader group(group_data);
+            while (group.next()) {
+                bool ok = true;
+                switch (group.field()) {
+                    case 1: ok = read_node(group.bytes(), block, to_coords); break;
+                    case 2: ok = read_dense_nodes(group.bytes(), block, to_coords); break;
+                    case 3: ok = read_way(group.bytes(), block); break;
+                    default: group.skip(); break;
+                }
+                if (!ok) return false;
+            }
+            if (!group.ok()) return false;
+        }
 
+        return true;
     }
 
-private:
-    [[nodiscard]] static Vector2 convert_vertex_pos(Vector2 pos) {
-        return pos * Vector2 { WIDTH, HEIGHT };
+    template <typename ToCoords>
+    [[nodiscard]] bool read_node(std::span<const uint8_t> data, OsmBlock &block, ToCoords to_coords) {
+        int64_t id = 0;
+        int64_t lat = 0;
+        int64_t lon = 0;
+
+        ProtoReader node(data);
+        while (node.next()) {
+            switch (node.field()) {
+                case 1: id = node.svarint(); break;
+                case 8: lat = node.svarint(); break;
+                case 9: lon = node.svarint(); break;
+                default: node.skip(); break;
+            }
+        }
+        if (!node.ok()) return false;
+
+        block.m_nodes.push_back({ id, to_coords(lat, lon) });
+        return true;
     }
 
-    void draw_vertex(VertexId id, Vertex vtx) const {
+    template <typename ToCoords>
+    [[nodiscard]] bool read_dense_nodes(std::span<const uint8_t> data, OsmBlock &block, ToCoords to_coords) {
+        m_ids.clear();
+        m_lats.clear();
+        m_lons.clear();
+        auto append_to = [](std::vector<uint64_t> &values) {
+            return [&values](uint64_t value) { values.push_back(value); };
+        };
+
+        bool ok = true;
+        ProtoReader dense(data);
+        while (dense.next()) {
+            switch (dense.field()) {
+                case 1: ok = ok && for_each_packed_varint(dense.bytes(), append_to(m_ids)); break;
+                case 8: ok = ok && for_each_packed_varint(dense.bytes(), append_to(m_lats)); break;
+                case 9: ok = ok && for_each_packed_varint(dense.bytes(), append_to(m_lons)); break;
+                default: dense.skip(); break;
+            }
+        }
+        if (!ok || !dense.ok()) return false;
+        if (m_ids.size() != m_lats.size() || m_ids.size() != m_lons.size()) return false;
+
+        // all three columns are delta coded
+        int64_t id = 0;
+        int64_t lat = 0;
+        int64_t lon = 0;
+        for (size_t i = 0; i < m_ids.size(); ++i) {
+            id += zigzag_decode(m_ids[i]);
+            lat += zigzag_decode(m_lats[i]);
+            lon += zigzag_decode(m_lons[i]);
+            block.m_nodes.push_back({ id, to_coords(lat, lon) });
+        }
 
-        auto pos = convert_vertex_pos(vtx.m_pos);
-        auto color = vtx.m_id == m_solver.m_current ? RED : BLUE;
+        return true;
+    }
 
-        if (m_solver.m_state == Solver::State::Visiting) {
-            auto neighbour = m_solver.m_neighbour->m_other_id;
-            if (vtx.m_id == neighbour)
-                color = GREEN;
+    [[nodiscard]] bool read_way(std::span<const uint8_t> data, OsmBlock &block) {
+        m_keys.clear();
+        m_values.clear();
+        m_refs.clear();
+        auto append_to = [](std::vector<uint64_t> &values) {
+            return [&values](uint64_t value) { values.push_back(value); };
+        };
+
+        bool ok = true;
+        int64_t ref = 0;
+        ProtoReader way(data);
+        while (way.next()) {
+            switch (way.field()) {
+                case 2: ok = ok && for_each_packed_varint(way.bytes(), append_to(m_keys)); break;
+                case 3: ok = ok && for_each_packed_varint(way.bytes(), append_to(m_values)); break;
+                // delta coded
+                case 8: ok = ok && for_each_packed_varint(way.bytes(), [&](uint64_t value) {
+                    ref += zigzag_decode(value);
+                    m_refs.push_back(ref);
+                }); break;
+                default: way.skip(); break;
+            }
         }
-
-        if (m_solver.m_state == Solver::State::Terminated) {
-            // TODO: make dest configurable
-            auto path = m_solver.get_optimal_path(3);
-            bool exists = ranges::find(path, id) != path.end();
-            if (exists) {
-                color = PURPLE;
+        if (!ok || !way.ok() || m_keys.size() != m_values.size()) return false;
+
+        double speed = 0;
+        if (m_metric == Metric::TravelTime) {
+            std::optional<std::string_view> highway;
+            std::optional<std::string_view> maxspeed;
+            for (size_t i = 0; i < m_keys.size(); ++i) {
+                if (m_keys[i] >= m_strings.size() || m_values[i] >= m_strings.size()) return false;
+                auto key = m_strings[m_keys[i]];
+                if (key == "highway") highway = m_strings[m_values[i]];
+                if (key == "maxspeed") maxspeed = m_strings[m_values[i]];
             }
+            speed = speed_kmh_from_tags(highway, maxspeed);
         }
 
-        float radius = 30;
-        DrawCircleV(convert_vertex_pos(vtx.m_pos), radius, color);
-
-        float fontsize = 50;
-        draw_text_centered(std::format("{}", id), pos, fontsize, WHITE);
+        block.add_way(m_refs, speed);
+        return true;
     }
 
-    void draw_ui() const {
+};
 
-        DrawText(
-            std::format("unvisited: {}", m_solver.m_unvisited).c_str(),
-            0,
-            0,
-            m_fontsize,
-            WHITE
-        );
+// reads an .osm.pbf file directly, without converting it to xml first
+// blobs are decoded on thread_count threads, the graph is the same for any thread count
+// nullopt if the file can't be read or is malformed
+[[nodiscard]] static std::optional<Graph> vertices_from_pbf(const char *filename, Metric metric = Metric::Length,
+                                                           unsigned thread_count = default_thread_count()) {
+    auto &reporter = load_reporter();
+    reporter.begin("read");
+
+    OsmGraphBuilder builder(metric);
+
+    OsmPbfReader reader(filename);
+    if (!reader.is_open()) return std::nullopt;
+
+    // no batch has more than OSM_BATCH_SIZE blobs, so no more workers than that
+    std::vector<OsmPbfDecoder> decoders(worker_count(OSM_BATCH_SIZE, thread_count), OsmPbfDecoder(metric));
+    std::vector<std::string> types(OSM_BATCH_SIZE);
+    std::vector<std::vector<uint8_t>> blobs(OSM_BATCH_SIZE);
+    std::vector<OsmBlock> blocks(OSM_BATCH_SIZE);
+
+    while (true) {
+        reporter.phase("read");
+        size_t count = 0;
+        while (count < OSM_BATCH_SIZE && reader.next_blob(types[count], blobs[count])) {
+            count++;
+        }
+        if (!reader.ok()) return std::nullopt;
+        if (count == 0) break;
+
+        reporter.phase("decode");
+        std::atomic<bool> failed = false;
+        parallel_for(count, thread_count, [&](size_t i, unsigned worker) {
+            blocks[i].clear();
+            if (!decoders[worker].decode(types[i], blobs[i], blocks[i])) failed = true;
+            reporter.add(blocks[i].m_nodes.size(), blocks[i].way_count(), blobs[i].size());
+        });
+        if (failed) return std::nullopt;
 
-        DrawText(
-            std::format("state: {}", m_solver.stringify_state(m_solver.m_state)).c_str(),
-            0,
-            m_fontsize,
-            m_fontsize,
-            WHITE
-        );
+        reporter.phase("merge");
+        merge_osm_blocks(builder, std::span(blocks).first(count), thread_count);
+    }
+    reporter.phase("build");
 
-        draw_distance_table({ 0, m_fontsize*3 });
+    auto graph = builder.build();
+    reporter.finish(filename, graph);
+    return graph;
+}
+
+// graph of an osm file, with the fastest loader for its format (.osm or .osm.pbf)
+// without a file, a grid_size x grid_size grid instead, as a fixture for benchmarks
+// nullopt if the file can't be parsed
+[[nodiscard]] static std::optional<Graph> load_osm_graph(const char *filename, int grid_size = 0) {
+    if (filename == nullptr) {
+        assert(grid_size > 0);
+        return Graph(generate_grid_vertices(grid_size, grid_size));
     }
+    if (std::string_view(filename).ends_with(".pbf")) {
+        return vertices_from_pbf(filename);
+    }
+    return vertices_from_xml_parallel(filename);
+}
 
-    void draw_distance_table(Vector2 pos) const {
-        for (auto &&[idx, kv] : std::views::enumerate(m_solver.m_table)) {
-            auto &[key, entry] = kv;
+// loads the graph of an osm file (.osm or .osm.pbf) from a snapshot, which is written on the first run
+// and again whenever the osm file is newer than it. nullopt if the osm file can't be parsed
+[[nodiscard]] static std::optional<Graph> graph_from_osm_cached(const char *filename, const char *snapshot) {
+    std::error_code source_error;
+    std::error_code snapshot_error;
+    auto source_time = std::filesystem::last_write_time(filename, source_error);
+    auto snapshot_time = std::filesystem::last_write_time(snapshot, snapshot_error);
 
-            DrawText(
-                std::format("{}: {} {}", key, entry.m_dist, entry.m_prev).c_str(),
-                pos.x,
-                m_fontsize * idx + pos.y,
-                m_fontsize,
-                WHITE
-            );
+    if (!snapshot_error && (source_error || snapshot_time >= source_time)) {
+        if (auto graph = Graph::load(snapshot)) return graph;
+    }
 
-        }
+    auto graph = load_osm_graph(filename);
+    if (!graph) return std::nullopt;
+    // paid once when the snapshot is written, every search on the mapped graph profits from it
+    graph = graph->permuted(hilbert_order(*graph));
+
+    if (!graph->save(snapshot)) {
+        std::println(stderr, "failed to write graph snapshot {}", snapshot);
     }
+    return graph;
+}
 
-    void draw_neighbours(Vector2 vertex_pos, std::span<const Edge> edges) const {
+template <typename Fn>
+[[nodiscard]] static double measure_seconds(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
 
-        for (const auto &edge : edges) {
+// count (source, dest) pairs of uniformly random vertices, the same ones for the same seed
+[[nodiscard]] static std::vector<std::pair<VertexId, VertexId>> random_vertex_pairs(const Graph &graph, size_t count, unsigned seed = 0) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<VertexIndex> vertex(0, graph.size()-1);
+    std::vector<std::pair<VertexId, VertexId>> pairs;
+    pairs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        pairs.push_back({ graph.id(vertex(rng)), graph.id(vertex(rng)) });
+    }
+    return pairs;
+}
 
-            VertexId id = edge.m_other_id;
-            auto vtx = m_solver.m_vertices.at(id);
-            auto pos = convert_vertex_pos(vtx.m_pos);
+static void bench_solver() {
+    int size = 1000;
+    Graph graph(generate_grid_vertices(size, size));
+    std::println("graph: {} vertices, {} arcs", graph.size(), graph.arc_count());
 
-            DrawLineEx(vertex_pos, pos, 3, GRAY);
+    Solver solver(graph, graph.id(0));
 
-            // TODO:
-            // auto diff = pos - vertex_pos;
-            // float dist = Vector2Length(diff) / 2.0f;
-            // auto line_middle = vertex_pos + Vector2Normalize(diff) * dist;
-            // float fontsize = 50;
-            // draw_text_centered(std::format("{}", edge.m_weight), line_middle, fontsize, WHITE);
+    double stepped = measure_seconds([&] {
+        while (!solver.is_done()) {
+            solver.next();
+        }
+    });
+
+    solver.reset();
+    double solved = measure_seconds([&] { solver.solve(); });
+
+    // a target in the middle of the grid, so early termination can skip about half of it
+    VertexId dest = graph.id(size * (size/2) + size/2);
+    std::optional<Route<uint64_t>> route;
+    double query = measure_seconds([&] { route = shortest_path(graph, graph.id(0), dest); });
+    assert(route.has_value());
+    assert(route->m_dist == solver.get_route(dest)->m_dist);
+
+    std::println("next(): {:.3f}s", stepped);
+    std::println("solve(): {:.3f}s ({:.2f}x)", solved, stepped / solved);
+    std::println("shortest_path(): {:.3f}s, dist: {}, hops: {}", query, route->m_dist, route->m_path.size());
+
+    auto bench_distance_type = [&]<Distance Dist>(const char *name) {
+        Solver<Dist> solver(graph, graph.id(0));
+        double seconds = measure_seconds([&] { solver.solve(); });
+        std::println("solve() with {} distances: {:.3f}s", name, seconds);
+    };
+    bench_distance_type.operator()<uint32_t>("uint32");
+    bench_distance_type.operator()<uint64_t>("uint64");
+    bench_distance_type.operator()<float>("float");
+}
 
+static void bench_astar() {
+    int size = 1000;
+    Graph graph(generate_grid_vertices(size, size));
+    std::println("graph: {} vertices, {} arcs", graph.size(), graph.arc_count());
+
+    // same queries for both algorithms
+    auto pairs = random_vertex_pairs(graph, 20);
+    size_t queries = pairs.size();
+    // dijkstra's routes, A* has to find routes of the same length
+    std::vector<std::optional<Route<uint64_t>>> expected;
+
+    for (auto algorithm : { Algorithm::Dijkstra, Algorithm::AStar }) {
+        size_t visited = 0;
+        double seconds = 0;
+
+        for (auto &&[i, pair] : std::views::enumerate(pairs)) {
+            auto [source, dest] = pair;
+            Solver solver(graph, source, dest, algorithm);
+            seconds += measure_seconds([&] { solver.solve(); });
+            visited += solver.visited_count();
+
+            auto route = solver.get_route(dest);
+            if (algorithm == Algorithm::Dijkstra) {
+                expected.push_back(std::move(route));
+            } else {
+                assert(route.has_value() && route->m_dist == expected[i]->m_dist);
+            }
         }
 
+        std::println(
+            "{}: {:.3f}s, {} visited vertices per query",
+            algorithm == Algorithm::AStar ? "A*" : "dijkstra",
+            seconds,
+            visited / queries
+        );
     }
-
-};
-
-[[nodiscard]] static double random_number() {
-    std::mt19937 rng(std::random_device{}());
-    return static_cast<double>(rng()) / rng.max();
 }
 
-[[nodiscard]] static std::unordered_map<VertexId, Vertex> generate_random_vertices(int n) {
-    int max_weight = 10;
-    std::unordered_map<VertexId, Vertex> verts;
-
-    std::vector<VertexId> nodes;
-    nodes.resize(n);
-    ranges::iota(nodes, 1);
+static void bench_bidirectional() {
+    int size = 1000;
+    Graph graph(generate_grid_vertices(size, size));
+    std::println("graph: {} vertices, {} arcs", graph.size(), graph.arc_count());
 
-    for (auto &node : nodes) {
-        Vector2 pos { static_cast<float>(random_number()), static_cast<float>(random_number()) };
-        verts[node] = { node, { }, pos };
+    auto pairs = random_vertex_pairs(graph, 20);
+    size_t queries = pairs.size();
 
-    }
+    size_t dijkstra_visited = 0;
+    size_t bidirectional_visited = 0;
+    double dijkstra_seconds = 0;
+    double bidirectional_seconds = 0;
+    BidirectionalSolver bidirectional(graph);
 
-    for (auto &node : nodes) {
+    for (auto [source, dest] : pairs) {
 
-        std::vector<Edge> neighbours;
-        for (auto &other : nodes) {
-            if (other != node)
-                neighbours.push_back({ other, static_cast<int>(random_number() * static_cast<double>(max_weight)) });
-        }
+        Solver solver(graph, source, dest);
+        std::optional<Route<uint64_t>> expected;
+        dijkstra_seconds += measure_seconds([&] { expected = solver.query(dest); });
+        dijkstra_visited += solver.visited_count();
 
-        verts[node].m_neighbours = neighbours;
+        std::optional<Route<uint64_t>> route;
+        bidirectional_seconds += measure_seconds([&] { route = bidirectional.query(source, dest); });
+        bidirectional_visited += bidirectional.visited_count();
 
+        assert(route.has_value() && route->m_dist == expected->m_dist);
     }
 
-    return verts;
+    std::println("dijkstra: {:.3f}s, {} visited vertices per query", dijkstra_seconds, dijkstra_visited / queries);
+    std::println("bidirectional: {:.3f}s, {} visited vertices per query", bidirectional_seconds, bidirectional_visited / queries);
 }
 
-[[nodiscard]] static auto xml_get_child_elements(tinyxml2::XMLElement *elem, const char *name) {
-    assert(elem != nullptr);
+static void bench_contraction_hierarchy() {
+    int size = 300;
+    Graph graph(generate_grid_vertices(size, size));
+    std::println("graph: {} vertices, {} arcs", graph.size(), graph.arc_count());
+
+    std::optional<ContractionHierarchy<>> ch;
+    double preprocessing = measure_seconds([&] { ch.emplace(graph); });
+    std::println("contraction: {:.3f}s, {} shortcuts", preprocessing, ch->shortcut_count());
+
+    const char *filename = "/tmp/pathfinding-bench.ch";
+    bool saved = ch->save(filename);
+    assert(saved);
+    std::optional<ContractionHierarchy<>> loaded;
+    double loading = measure_seconds([&] {
+        if (auto ch = ContractionHierarchy<>::load(graph, filename)) loaded.emplace(std::move(*ch));
+    });
+    assert(loaded.has_value());
+    std::println("load: {:.3f}s", loading);
+
+    auto pairs = random_vertex_pairs(graph, 1000);
+    size_t queries = pairs.size();
+
+    size_t dijkstra_visited = 0;
+    size_t ch_visited = 0;
+    double dijkstra_seconds = 0;
+    double ch_seconds = 0;
+
+    for (auto [source, dest] : pairs) {
+
+        Solver solver(graph, source);
+        std::optional<Route<uint64_t>> expected;
+        dijkstra_seconds += measure_seconds([&] { expected = solver.query(dest); });
+        dijkstra_visited += solver.visited_count();
+
+        std::optional<Route<uint64_t>> route;
+        ch_seconds += measure_seconds([&] { route = loaded->query(source, dest); });
+        ch_visited += loaded->visited_count();
+
+        assert(route.has_value() && route->m_dist == expected->m_dist);
+    }
 
-    std::vector<tinyxml2::XMLElement*> elems;
+    std::println("dijkstra: {:.1f}us, {} visited vertices per query", dijkstra_seconds / queries * 1e6, dijkstra_visited / queries);
+    std::println("contraction hierarchy: {:.1f}us, {} visited vertices per query", ch_seconds / queries * 1e6, ch_visited / queries);
+}
 
-    tinyxml2::XMLElement *node = elem->FirstChildElement(name);
-    while (node != nullptr) {
-        elems.push_back(node);
-        node = node->NextSiblingElement(name);
+// peak resident set size of the process in KiB, 0 if /proc is not available
+[[nodiscard]] static size_t peak_rss_kib() {
+    FILE *status = std::fopen("/proc/self/status", "r");
+    if (status == nullptr) return 0;
+
+    size_t kib = 0;
+    char line[256];
+    while (std::fgets(line, sizeof line, status) != nullptr) {
+        if (std::sscanf(line, "VmHWM: %zu kB", &kib) == 1) break;
     }
 
-    return elems;
+    std::fclose(status);
+    return kib;
 }
 
-[[nodiscard]] static constexpr Vector2 vec2_from_lat_lon(float lat, float lon, float width, float height) {
-    float x = ((width/360.0) * (180 + lon));
-    float y = ((height/180.0) * (90 - lat));
-    return { x, y };
+// the peak rss covers the whole process, so only one loader is measured per run
+static void bench_loader(const char *filename, std::string_view mode) {
+    std::optional<Graph> graph;
+    double seconds = measure_seconds([&] {
+        if (mode == "dom") {
+            graph = vertices_from_xml(filename);
+        } else if (mode == "pbf") {
+            graph = vertices_from_pbf(filename);
+        } else if (mode == "parallel") {
+            graph = vertices_from_xml_parallel(filename);
+        } else {
+            graph = vertices_from_osm_stream(filename);
+        }
+    });
+    if (!graph) {
+        std::println(stderr, "failed to load {}", filename);
+        return;
+    }
+    std::println("{} ({}): {:.3f}s, {} vertices, {} arcs, peak rss {} KiB",
+                 filename, mode, seconds, graph->size(), graph->arc_count(), peak_rss_kib());
 }
 
-[[nodiscard]] static auto vertices_from_xml(const char *filename) {
-    std::unordered_map<VertexId, Vertex> vertices;
+// parsing an osm file against mapping a snapshot of its graph, up to the first answered query
+static void bench_snapshot(const char *filename) {
+    const char *snapshot = "/tmp/pathfinding-bench.graph";
 
-    tinyxml2::XMLDocument doc;
-    doc.LoadFile(filename);
+    std::optional<Graph> parsed;
+    double parse_seconds = measure_seconds([&] {
+        parsed = load_osm_graph(filename);
+    });
+    assert(parsed.has_value());
+    std::println("graph: {} vertices, {} arcs", parsed->size(), parsed->arc_count());
 
-    auto osm = doc.FirstChildElement("osm");
-    assert(osm != nullptr);
+    bool saved = false;
+    double save_seconds = measure_seconds([&] { saved = parsed->save(snapshot); });
+    assert(saved);
 
-    auto nodes = xml_get_child_elements(osm, "node");
+    std::optional<Graph> loaded;
+    double load_seconds = measure_seconds([&] { loaded = Graph::load(snapshot); });
+    assert(loaded.has_value() && loaded->size() == parsed->size() && loaded->arc_count() == parsed->arc_count());
 
-    for (auto &node : nodes) {
-        auto id = node->Attribute("id");
-        auto lat = node->Attribute("lat");
-        auto lon = node->Attribute("lon");
+    auto [source, dest] = random_vertex_pairs(*loaded, 1).front();
 
-        VertexId vtx_id = 0;
-        std::from_chars(id, id + strlen(id), vtx_id);
+    std::optional<Route<uint64_t>> route;
+    double query_seconds = measure_seconds([&] { route = BidirectionalSolver(*loaded).query(source, dest); });
+    auto expected = BidirectionalSolver(*parsed).query(source, dest);
+    assert(route.has_value() == expected.has_value() && (!route || route->m_dist == expected->m_dist));
 
-        float latf = 0;
-        std::from_chars(lat, lat + strlen(lat), latf);
+    std::println("parse: {:.3f}s, save: {:.3f}s", parse_seconds, save_seconds);
+    std::println("load: {:.6f}s, first query after load: {:.3f}s", load_seconds, query_seconds);
 
-        float lonf = 0;
-        std::from_chars(lon, lon + strlen(lon), lonf);
+    // the cached loader parses and writes the snapshot on the first call, later calls only map it
+    const char *cached_snapshot = "/tmp/pathfinding-bench-cached.graph";
+    std::error_code error;
+    std::filesystem::remove(cached_snapshot, error);
 
-        Vector2 pos = vec2_from_lat_lon(latf, lonf, 1.0f, 1.0f);
-        std::println("id: {}, x: {}, y: {}", id, pos.x, pos.y);
+    std::optional<Graph> built;
+    double build_seconds = measure_seconds([&] { built = graph_from_osm_cached(filename, cached_snapshot); });
+    std::optional<Graph> cached;
+    double cached_seconds = measure_seconds([&] { cached = graph_from_osm_cached(filename, cached_snapshot); });
+    assert(built.has_value() && cached.has_value());
+    assert(cached->size() == parsed->size() && cached->arc_count() == parsed->arc_count());
 
-        pos.x -= 0.52;
-        pos.y -= 0.22;
-        pos *= 30;
+    auto cached_route = BidirectionalSolver(*cached).query(source, dest);
+    assert(cached_route.has_value() == expected.has_value() && (!cached_route || cached_route->m_dist == expected->m_dist));
+
+    std::println("cached loader: {:.3f}s to build and save, {:.6f}s once cached", build_seconds, cached_seconds);
+}
+
+// memory saved by dropping the nodes that aren't part of a way, and then everything outside the largest component
+static void bench_prune(const char *filename) {
+    auto graph = load_osm_graph(filename);
+    assert(graph.has_value());
+
+    auto kib = [](size_t bytes) { return bytes / 1024; };
+    auto &reporter = load_reporter();
+    std::println("graph: {} vertices, {} arcs, {} KiB", graph->size(), graph->arc_count(), kib(graph->memory_bytes()));
+    std::println("not part of a way: {} vertices, {} KiB", reporter.pruned_count(), kib(reporter.pruned_bytes()));
+
+    std::optional<Graph> component;
+    double seconds = measure_seconds([&] { component.emplace(largest_strongly_connected_component(*graph)); });
+    std::println("largest component: {} vertices, {} arcs, {} KiB in {:.3f}s, saves {} vertices, {} KiB",
+                 component->size(), component->arc_count(), kib(component->memory_bytes()), seconds,
+                 graph->size() - component->size(), kib(graph->memory_bytes() - component->memory_bytes()));
+}
 
-        vertices[vtx_id] = { vtx_id, { }, pos };
+// size of the routing graph and query time before and after contracting degree 2 chains
+static void bench_chains(const char *filename) {
+    auto graph = load_osm_graph(filename);
+    assert(graph.has_value());
+
+    PolylineStore polylines;
+    std::optional<Graph> contracted;
+    double seconds = measure_seconds([&] { contracted.emplace(contract_chains(graph_vertices(*graph), polylines)); });
+
+    auto kib = [](size_t bytes) { return bytes / 1024; };
+
+    std::println("graph: {} vertices, {} arcs, {} KiB", graph->size(), graph->arc_count(), kib(graph->memory_bytes()));
+    std::println("contracted: {} vertices, {} arcs, {} KiB in {:.3f}s, {:.1f}x fewer vertices",
+                 contracted->size(), contracted->arc_count(), kib(contracted->memory_bytes()), seconds,
+                 static_cast<double>(graph->size()) / contracted->size());
+    std::println("polylines: {} vertices, {} KiB", polylines.vertex_count(), kib(polylines.memory_bytes()));
+
+    auto pairs = random_vertex_pairs(*contracted, 20);
+    double graph_seconds = 0;
+    double contracted_seconds = 0;
+
+    for (auto [source, dest] : pairs) {
+        std::optional<Route<uint64_t>> expected;
+        graph_seconds += measure_seconds([&] { expected = shortest_path(*graph, source, dest); });
+
+        std::optional<Route<uint64_t>> route;
+        contracted_seconds += measure_seconds([&] { route = shortest_path(*contracted, source, dest); });
+
+        assert(route.has_value() == expected.has_value());
+        if (!route) continue;
+        assert(route->m_dist == expected->m_dist);
+
+        // the unpacked route has to be a path of the same length in the original graph
+        auto unpacked = polylines.unpack(*route);
+        uint64_t dist = 0;
+        for (size_t j = 1; j < unpacked.m_path.size(); ++j) {
+            auto arcs = graph->neighbours(graph->index(unpacked.m_path[j-1]));
+            VertexIndex target = graph->index(unpacked.m_path[j]);
+            auto arc = ranges::min_element(arcs, { }, [&](const Arc &arc) {
+                return arc.m_target == target ? arc.m_weight : std::numeric_limits<uint64_t>::max();
+            });
+            assert(arc != arcs.end() && arc->m_target == target);
+            dist += arc->m_weight;
+        }
+        assert(dist == route->m_dist);
     }
 
-    auto ways = xml_get_child_elements(osm, "way");
+    std::println("{} queries: {:.3f}s on the graph, {:.3f}s contracted", pairs.size(), graph_seconds, contracted_seconds);
+}
 
-    for (auto &way : ways) {
-        auto nds = xml_get_child_elements(way, "nd");
+// settled vertices per second of full dijkstra searches, with the vertices stored in id, bfs and hilbert order
+static void bench_vertex_order(const char *filename) {
+    auto graph = load_osm_graph(filename);
+    assert(graph.has_value());
+    std::println("graph: {} vertices, {} arcs", graph->size(), graph->arc_count());
+
+    auto pairs = random_vertex_pairs(*graph, 10);
+    // distances in id order, the other orders have to find the same ones
+    std::vector<std::optional<uint64_t>> expected;
+
+    auto bench_order = [&](const char *name, auto order) {
+        std::optional<Graph> ordered;
+        double reorder_seconds = measure_seconds([&] { ordered.emplace(graph->permuted(order(*graph))); });
+
+        size_t settled = 0;
+        double seconds = 0;
+        for (auto &&[i, pair] : std::views::enumerate(pairs)) {
+            auto [source, dest] = pair;
+            Solver solver(*ordered, source);
+            seconds += measure_seconds([&] { solver.solve(); });
+            settled += solver.visited_count();
+
+            auto route = solver.get_route(dest);
+            auto dist = route ? std::optional(route->m_dist) : std::nullopt;
+            if (expected.size() < pairs.size()) {
+                expected.push_back(dist);
+            }
+            assert(dist == expected[i]);
+        }
+
+        std::println("{}: reordered in {:.3f}s, {} queries in {:.3f}s, {:.2f}M settled vertices/s",
+                     name, reorder_seconds, pairs.size(), seconds, settled / seconds / 1e6);
+    };
+
+    bench_order("id", [](const Graph &graph) {
+        std::vector<VertexIndex> order(graph.size());
+        std::iota(order.begin(), order.end(), VertexIndex { 0 });
+        return order;
+    });
+    bench_order("bfs", bfs_order);
+    bench_order("hilbert", hilbert_order);
+}
+
+// load time of the parallel loaders for 1, 2, 4, ... up to max_threads threads
+static void bench_loader_threads(const char *filename, unsigned max_threads) {
+    bool pbf = std::string_view(filename).ends_with(".pbf");
+
+    double single = 0;
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+        std::optional<Graph> graph;
+        double seconds = measure_seconds([&] {
+            if (pbf) {
+                graph = vertices_from_pbf(filename, Metric::Length, threads);
+            } else {
+                graph = vertices_from_xml_parallel(filename, Metric::Length, threads);
+            }
+        });
+        if (!graph) {
+            std::println(stderr, "failed to load {}", filename);
+            return;
+        }
+
+        if (threads == 1) single = seconds;
+        std::println("{:>3} threads: {:.3f}s, speedup {:.2f}, {} vertices, {} arcs",
+                     threads, seconds, single / seconds, graph->size(), graph->arc_count());
 
-        auto first_str = nds[0]->Attribute("ref");
-        VertexId first = 0;
-        std::from_chars(first_str, first_str + strlen(first_str), first);
+        if (threads == max_threads) break;
+    }
+}
+
+// heap allocations of a second search after reset(), which has to reuse everything the first one allocated
+// allocations are only counted in builds with -DPATHFINDING_COUNT_ALLOCATIONS
+static void bench_allocations() {
+#ifndef PATHFINDING_COUNT_ALLOCATIONS
+    std::println(stderr, "allocations are not counted, build with -DPATHFINDING_COUNT_ALLOCATIONS");
+#else
+    int size = 300;
+    Graph graph(generate_grid_vertices(size, size));
+    std::println("graph: {} vertices, {} arcs", graph.size(), graph.arc_count());
+
+    auto count_allocations = [](auto fn) {
+        size_t before = allocation_count;
+        fn();
+        return allocation_count - before;
+    };
 
-        auto last_str = nds[nds.size()-1]->Attribute("ref");
-        VertexId last = 0;
-        std::from_chars(last_str, last_str + strlen(last_str), last);
+    Solver solver(graph, graph.id(0));
+    size_t first = count_allocations([&] { solver.solve(); });
+    solver.reset();
+    size_t second = count_allocations([&] { solver.solve(); });
+    std::println("solve(): {} allocations, after reset(): {}", first, second);
+    assert(second == 0);
+
+    VertexId dest = graph.id(graph.size() - 1);
+    size_t again = count_allocations([&] { (void)solver.query_distance(graph.id(0), dest); });
+    std::println("query_distance() on a used solver: {} allocations", again);
+    assert(again == 0);
+#endif
+}
 
-        // vertices[first].m_neighbours.push_back({ last, 1 });
-        // vertices[last].m_neighbours.push_back({ first, 1 });
+// short queries on a big graph, with a new solver for every query and with one solver whose workspace is reused
+// on a grid if no file is given
+static void bench_workspace(const char *filename) {
+    auto graph = load_osm_graph(filename, 1000);
+    assert(graph.has_value());
+    std::println("graph: {} vertices, {} arcs", graph->size(), graph->arc_count());
+
+    // destinations a short random walk away from the source, so a query only settles a few hundred vertices
+    auto queries = random_vertex_pairs(*graph, 2000);
+    std::mt19937 rng(0);
+    for (auto &[source, dest] : queries) {
+        VertexIndex idx = graph->index(source);
+        for (int step = 0; step < 10; ++step) {
+            auto arcs = graph->neighbours(idx);
+            if (arcs.empty()) break;
+            idx = arcs[rng() % arcs.size()].m_target;
+        }
+        dest = graph->id(idx);
+    }
 
-        for (auto &nd : nds) {
-            auto id_str = nd->Attribute("ref");
-            VertexId id = 0;
-            std::from_chars(id_str, id_str + strlen(id_str), id);
+    std::vector<std::optional<uint64_t>> fresh(queries.size());
+    double fresh_seconds = measure_seconds([&] {
+        for (auto &&[i, query] : std::views::enumerate(queries)) {
+            Solver solver(*graph, query.first);
+            fresh[i] = solver.query_distance(query.first, query.second);
+        }
+    });
 
-            for (auto &other : nds) {
-                auto other_str = other->Attribute("ref");
-                VertexId other_id = 0;
-                std::from_chars(other_str, other_str + strlen(other_str), other_id);
+    std::vector<std::optional<uint64_t>> reused(queries.size());
+    Solver solver(*graph, queries.front().first);
+    double reused_seconds = measure_seconds([&] {
+        for (auto &&[i, query] : std::views::enumerate(queries)) {
+            reused[i] = solver.query_distance(query.first, query.second);
+        }
+    });
+    assert(fresh == reused);
 
-                if (other_id == id) continue;
+    std::println("new solver per query: {:.3f}s, {:.0f} queries/s", fresh_seconds, queries.size() / fresh_seconds);
+    std::println("reused workspace: {:.3f}s, {:.0f} queries/s, {:.1f}x", reused_seconds, queries.size() / reused_seconds,
+                 fresh_seconds / reused_seconds);
+}
 
-                vertices[id].m_neighbours.push_back(Edge { other_id, 1 });
+// sources x targets distance matrix from a query per pair, from distance_matrix() on 1 and on all threads, and from
+// the buckets of a contraction hierarchy. on a grid if no file is given
+static void bench_distance_matrix(const char *filename, size_t source_count, size_t target_count) {
+    auto graph = load_osm_graph(filename, 300);
+    assert(graph.has_value());
+    std::println("graph: {} vertices, {} arcs, {} x {} matrix", graph->size(), graph->arc_count(), source_count, target_count);
+
+    auto pairs = random_vertex_pairs(*graph, std::max(source_count, target_count));
+    std::vector<VertexId> sources;
+    std::vector<VertexId> targets;
+    for (size_t i = 0; i < source_count; ++i) sources.push_back(pairs[i].first);
+    for (size_t i = 0; i < target_count; ++i) targets.push_back(pairs[i].second);
+
+    DistanceMatrix<uint64_t> expected { sources.size(), targets.size(), { } };
+    Solver solver(*graph, sources.front());
+    double pairs_seconds = measure_seconds([&] {
+        for (auto source : sources) {
+            for (auto target : targets) {
+                expected.m_dists.push_back(solver.query_distance(source, target).value_or(INF_DISTANCE<uint64_t>));
             }
+        }
+    });
+    std::println("query per pair: {:.3f}s", pairs_seconds);
+
+    for (unsigned threads : { 1u, default_thread_count() }) {
+        DistanceMatrix<uint64_t> matrix;
+        double seconds = measure_seconds([&] { matrix = distance_matrix(*graph, sources, targets, threads); });
+        assert(matrix.m_dists == expected.m_dists);
+        std::println("search per source, {} threads: {:.3f}s, {:.1f}x", threads, seconds, pairs_seconds / seconds);
+    }
 
+    std::optional<ContractionHierarchy<>> ch;
+    double preprocessing = measure_seconds([&] { ch.emplace(*graph); });
+    DistanceMatrix<uint64_t> matrix;
+    double seconds = measure_seconds([&] { matrix = ch->distance_matrix(sources, targets); });
+    assert(matrix.m_dists == expected.m_dists);
+    std::println("contraction hierarchy buckets: {:.3f}s, {:.1f}x, after {:.3f}s of contraction",
+                 seconds, pairs_seconds / seconds, preprocessing);
+}
+
+// queries per second of batch_distances() for 1, 2, 4, ... up to max_threads threads
+// on a grid if no file is given
+static void bench_batch(const char *filename, unsigned max_threads) {
+    auto graph = load_osm_graph(filename, 300);
+    assert(graph.has_value());
+    std::println("graph: {} vertices, {} arcs", graph->size(), graph->arc_count());
+
+    auto queries = random_vertex_pairs(*graph, 200);
+
+    double single = 0;
+    std::vector<std::optional<uint64_t>> expected;
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+        std::vector<std::optional<uint64_t>> distances;
+        double seconds = measure_seconds([&] { distances = batch_distances(*graph, queries, threads); });
+
+        // every thread count has to find the same distances
+        if (threads == 1) {
+            single = seconds;
+            expected = distances;
         }
+        assert(distances == expected);
 
+        std::println("{:>3} threads: {:.3f}s, {:.0f} queries/s, speedup {:.2f}",
+                     threads, seconds, queries.size() / seconds, single / seconds);
+
+        if (threads == max_threads) break;
     }
+}
 
-    return vertices;
+// time to get from a file on disk to a parsed dom, with the file read into a buffer or mapped
+static void bench_xml_load(const char *filename) {
+    int runs = 5;
+
+    auto bench = [&](const char *label, auto load) {
+        double best = std::numeric_limits<double>::infinity();
+        for (int i = 0; i < runs; ++i) {
+            tinyxml2::XMLDocument doc;
+            double seconds = measure_seconds([&] { load(doc); });
+            assert(!doc.Error());
+            best = std::min(best, seconds);
+        }
+        std::println("{:>8}: {:.3f}s (best of {})", label, best, runs);
+    };
+
+    bench("read", [&](tinyxml2::XMLDocument &doc) { doc.LoadFile(filename); });
+    bench("mmap", [&](tinyxml2::XMLDocument &doc) { doc.LoadFileMapped(filename); });
 }
 
-int main() {
+// args are the ones following the benchmark name
+[[nodiscard]] static int run_benchmark(std::string_view name, std::span<char*> args) {
+    if (name == "solver") {
+        bench_solver();
+    } else if (name == "astar") {
+        bench_astar();
+    } else if (name == "bidirectional") {
+        bench_bidirectional();
+    } else if (name == "ch") {
+        bench_contraction_hierarchy();
+    } else if (name == "loader") {
+        bench_loader(args.size() >= 1 ? args[0] : "./map.osm", args.size() >= 2 ? args[1] : "stream");
+    } else if (name == "order") {
+        bench_vertex_order(args.empty() ? "./map.osm" : args[0]);
+    } else if (name == "chains") {
+        bench_chains(args.empty() ? "./map.osm" : args[0]);
+    } else if (name == "prune") {
+        bench_prune(args.empty() ? "./map.osm" : args[0]);
+    } else if (name == "snapshot") {
+        bench_snapshot(args.empty() ? "./map.osm" : args[0]);
+    } else if (name == "threads") {
+        unsigned max_threads = args.size() >= 2 ? std::max(1, std::atoi(args[1])) : default_thread_count();
+        bench_loader_threads(args.size() >= 1 ? args[0] : "./map.osm", max_threads);
+    } else if (name == "matrix") {
+        size_t sources = args.size() >= 2 ? std::max(1, std::atoi(args[1])) : 20;
+        size_t targets = args.size() >= 3 ? std::max(1, std::atoi(args[2])) : 100;
+        bench_distance_matrix(args.size() >= 1 ? args[0] : nullptr, sources, targets);
+    } else if (name == "allocations") {
+        bench_allocations();
+    } else if (name == "workspace") {
+        bench_workspace(args.size() >= 1 ? args[0] : nullptr);
+    } else if (name == "batch") {
+        unsigned max_threads = args.size() >= 2 ? std::max(1, std::atoi(args[1])) : default_thread_count();
+        bench_batch(args.size() >= 1 ? args[0] : nullptr, max_threads);
+    } else if (name == "xml") {
+        bench_xml_load(args.empty() ? "./map.osm" : args[0]);
+    } else {
+        std::println(stderr, "unknown benchmark: {}", name);
+        std::println(stderr, "available: solver, allocations, astar, bidirectional, ch, loader [file] [stream|dom|pbf|parallel], threads [file] [max threads], snapshot [file], prune [file], chains [file], order [file], batch [file] [max threads], workspace [file], matrix [file] [sources] [targets], xml [file.osm]");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
 
-    // auto vertices = vertices_from_xml("./map.osm");
+    std::span<char*> args(argv, argc);
+    if (args.size() >= 2 && std::string_view(args[1]) == "bench") {
+        return run_benchmark(args.size() >= 3 ? args[2] : "", args.size() >= 3 ? args.subspan(3) : args.subspan(2));
+    }
+
+    // Graph graph = *vertices_from_xml("./map.osm");
+    // Graph graph = *vertices_from_pbf("./austria-latest.osm.pbf");
 
-    // auto vertices = generate_random_vertices(10);
+    // Graph graph = *graph_from_osm_cached("./map.osm", "./map.graph");
+    // Graph graph = largest_strongly_connected_component(*graph_from_osm_cached("./map.osm", "./map.graph"));
+
+    // Graph graph(generate_random_vertices(10));
 
     std::unordered_map<VertexId, Vertex> vertices {
         { 1, { 1, { { 2, 5 }, { 5, 2 } }, { 0.1, 0.5 } } },
@@ -454,10 +4685,13 @@ int main() {
         { 6, { 6, { }, { 0.35, 0.3 } } },
     };
 
-    std::println("vertices: {}", vertices.size());
+    Graph graph(vertices);
+
+    std::println("vertices: {}", graph.size());
 
-    // Solver solver(vertices, 12966960339);
-    Solver solver(vertices, 1);
+    // Solver solver(graph, 12966960339);
+    // Solver solver(graph, 1, 3, Algorithm::AStar);
+    Solver solver(graph, 1, 3);
     Renderer renderer(solver);
 
     SetTraceLogLevel(LOG_ERROR);
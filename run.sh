@@ -7,3 +7,18 @@ set -euxo pipefail
 c++ main.cc ./tinyxml2.cpp -o pathfinding -Wall -Wextra -std=c++23 -pedantic -O3 -ggdb -lraylib -fsanitize=undefined
 
 time ./pathfinding
+# time ./pathfinding bench solver
+# time ./pathfinding bench ch
+# time ./pathfinding bench loader ./map.osm stream
+# time ./pathfinding bench xml ./map.osm
+# time ./pathfinding bench loader ./austria-latest.osm.pbf pbf
+# time ./pathfinding bench threads ./austria-latest.osm.pbf
+# time ./pathfinding bench snapshot ./austria-latest.osm.pbf
+# time ./pathfinding bench prune ./austria-latest.osm.pbf
+# time ./pathfinding bench chains ./austria-latest.osm.pbf
+# time ./pathfinding bench order ./austria-latest.osm.pbf
+# time ./pathfinding bench batch ./austria-latest.osm.pbf
+# time ./pathfinding bench workspace
+# time ./pathfinding bench matrix ./austria-latest.osm.pbf 20 100
+# needs a build with the counting allocator: c++ ... -DPATHFINDING_COUNT_ALLOCATIONS
+# time ./pathfinding bench allocations
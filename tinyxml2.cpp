@@ -114,6 +114,13 @@ distribution.
 	#define TIXML_FTELL ftell
 #endif
 
+#if defined(TINYXML2_MMAP)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
 
 static const char LINE_FEED				= static_cast<char>(0x0a);			// all line endings are normalized to LF
 static const char LF = LINE_FEED;
@@ -1636,6 +1643,27 @@ const char* XMLElement::Attribute( const char* name, const char* value ) const
     return 0;
 }
 
+int XMLElement::Attributes( const char* const* names, const char** values, int count ) const
+{
+    TIXMLASSERT( count >= 0 );
+    for( int i = 0; i < count; ++i ) {
+        values[i] = 0;
+    }
+
+    int found = 0;
+    for( const XMLAttribute* a = _rootAttribute; a && found < count; a = a->_next ) {
+        const char* name = a->Name();
+        for( int i = 0; i < count; ++i ) {
+            if ( !values[i] && XMLUtil::StringEqual( name, names[i] ) ) {
+                values[i] = a->Value();
+                ++found;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
 int XMLElement::IntAttribute(const char* name, int defaultValue) const
 {
 	int i = defaultValue;
@@ -2189,6 +2217,7 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
     _errorStr(),
     _errorLineNum( 0 ),
     _charBuffer( 0 ),
+    _charBufferMappedSize( 0 ),
     _parseCurLineNum( 0 ),
 	_parsingDepth(0),
     _unlinked(),
@@ -2233,6 +2262,13 @@ void XMLDocument::Clear()
 #endif
     ClearError();
 
+#if defined(TINYXML2_MMAP)
+    if ( _charBufferMappedSize ) {
+        munmap( _charBuffer, _charBufferMappedSize );
+        _charBufferMappedSize = 0;
+        _charBuffer = 0;
+    }
+#endif
     delete [] _charBuffer;
     _charBuffer = 0;
 	_parsingDepth = 0;
@@ -2414,6 +2450,71 @@ XMLError XMLDocument::LoadFile( FILE* fp )
 }
 
 
+XMLError XMLDocument::LoadFileMapped( const char* filename )
+{
+#if defined(TINYXML2_MMAP)
+    if ( !filename ) {
+        TIXMLASSERT( false );
+        SetError( XML_ERROR_FILE_COULD_NOT_BE_OPENED, 0, "filename=<null>" );
+        return _errorID;
+    }
+
+    Clear();
+    const int fd = open( filename, O_RDONLY );
+    if ( fd == -1 ) {
+        SetError( XML_ERROR_FILE_NOT_FOUND, 0, "filename=%s", filename );
+        return _errorID;
+    }
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) ) {
+        close( fd );
+        SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
+        return _errorID;
+    }
+    if ( st.st_size == 0 ) {
+        close( fd );
+        SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
+        return _errorID;
+    }
+
+    // The parser needs a null terminator after the last byte. Reserve one
+    // more byte of zeroed anonymous memory, then map the file over the front
+    // of it. The file mapping is private: the parser writes terminators into
+    // the buffer, and those pages are copied on write instead of touching
+    // the file.
+    const size_t size = static_cast<size_t>( st.st_size );
+    const size_t pageSize = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+    const size_t mappedSize = ( size + 1 + pageSize - 1 ) / pageSize * pageSize;
+
+    void* reserved = mmap( 0, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( reserved == MAP_FAILED ) {
+        close( fd );
+        SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
+        return _errorID;
+    }
+    void* mapped = mmap( reserved, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0 );
+    close( fd );
+    if ( mapped == MAP_FAILED ) {
+        munmap( reserved, mappedSize );
+        SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
+        return _errorID;
+    }
+    madvise( mapped, size, MADV_SEQUENTIAL );
+
+    TIXMLASSERT( _charBuffer == 0 );
+    _charBuffer = static_cast<char*>( mapped );
+    _charBufferMappedSize = mappedSize;
+    TIXMLASSERT( _charBuffer[size] == 0 );
+
+    Parse();
+    return _errorID;
+#else
+    return LoadFile( filename );
+#endif
+}
+
+
 XMLError XMLDocument::SaveFile( const char* filename, bool compact )
 {
     if ( !filename ) {
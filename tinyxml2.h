@@ -42,6 +42,10 @@ distribution.
 #endif
 #include <stdint.h>
 
+#if !defined(TINYXML2_MMAP) && !defined(TINYXML2_NO_MMAP) && ( defined(__unix__) || defined(__APPLE__) )
+#   define TINYXML2_MMAP
+#endif
+
 /*
 	gcc:
         g++ -Wall -DTINYXML2_DEBUG tinyxml2.cpp xmltest.cpp -o gccxmltest.exe
@@ -1308,6 +1312,22 @@ public:
     */
     const char* Attribute( const char* name, const char* value=0 ) const;
 
+    /** Looks up several attributes in a single pass over the
+    	attribute list, instead of one pass per Attribute() call.
+    	values[i] is set to the value of the attribute called
+    	names[i], or null if none exists. Returns the number of
+    	attributes that were found. For example:
+
+    	@verbatim
+    	static const char* const names[] = { "id", "lat", "lon" };
+    	const char* values[3];
+    	if ( ele->Attributes( names, values, 3 ) == 3 ) {
+    		...
+    	}
+    	@endverbatim
+    */
+    int Attributes( const char* const* names, const char** values, int count ) const;
+
     /** Given an attribute name, IntAttribute() returns the value
     	of the attribute interpreted as an integer. The default
         value will be returned if the attribute isn't present,
@@ -1771,6 +1791,21 @@ public:
     */
     XMLError LoadFile( FILE* );
 
+    /**
+    	Load an XML file from disk by memory mapping it and
+    	parsing it in place, instead of reading it into a
+    	separate buffer. The mapping is private, so the file
+    	is never modified, and it is kept until the document
+    	is cleared or destroyed.
+
+        Falls back to LoadFile() on platforms without mmap,
+        or when TINYXML2_NO_MMAP is defined.
+
+    	Returns XML_SUCCESS (0) on success, or
+    	an errorID.
+    */
+    XMLError LoadFileMapped( const char* filename );
+
     /**
     	Save the XML file to disk.
     	Returns XML_SUCCESS (0) on success, or
@@ -1940,6 +1975,7 @@ private:
     mutable StrPair	_errorStr;
     int             _errorLineNum;
     char*			_charBuffer;
+    size_t			_charBufferMappedSize;	// non-zero if _charBuffer is a mapping, not new[]
     int				_parseCurLineNum;
 	int				_parsingDepth;
 	// Memory tracking does add some overhead.